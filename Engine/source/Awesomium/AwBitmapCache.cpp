@@ -0,0 +1,351 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwBitmapCache.h"
+#include "AwLZ4.h"
+#include "AwMappedFile.h"
+#include "AwManager.h"
+#include "platform/platform.h"
+#include "core/stream/stream.h"
+#include "core/volume.h"
+#include "core/stream/fileStream.h"
+#include "gfx/gfxDevice.h"
+#include "gfx/gfxTextureManager.h"
+
+Mutex AwBitmapCache::sMutex;
+Map <String, AwBitmapCache::Entry> AwBitmapCache::sEntries;
+String AwBitmapCache::sDirectory;
+U64 AwBitmapCache::sTotalSize												= 0;
+U64 AwBitmapCache::sQuota													= 0;
+bool AwBitmapCache::sIsDirty												= false;
+
+String AwBitmapCache::makeKey (const String &url, const Point2I &resolution, bool isTransparent, const String &version)
+{
+	String source = url + String::ToString ("|%ix%i|%i|%i|", resolution.x, resolution.y, isTransparent ? 1 : 0, (S32)Version) + version;
+
+	// 64-bit FNV-1a. Collisions only cost a wrong snapshot until the page has loaded, so this is plenty.
+	U64 hash = 14695981039346656037ULL;
+	for (U32 i = 0; i < source.length (); i++)
+	{
+		hash ^= (U8)source.c_str () [i];
+		hash *= 1099511628211ULL;
+	}
+
+	return String::ToString ("%08x%08x", (U32)(hash >> 32), (U32)hash);
+}
+
+String AwBitmapCache::getPath (const String &key, Format format)
+{
+	if (format == FormatPNG)
+	{
+		return sDirectory + "/" + key + "." + getExtension (format);
+	}
+
+	// .awc files hold the pixels in the texture layout. Direct3D and OpenGL disagree on the byte order of the same GFXFormat, so the name carries both
+	// the format and whether the pixels were swizzled. A device with another layout looks for its own file instead of finding one it can't use.
+	String layout = String::ToString ("-%x%x", (U32)AwManager::getTextureFormat (), (U32)AwManager::getTextureCopyMode ());
+	return sDirectory + "/" + key + layout + "." + getExtension (format);
+}
+
+void AwBitmapCache::init (const String &directory)
+{
+	MutexHandle handle;
+	handle.lock (&sMutex);
+
+	sDirectory = directory;
+	loadManifest ();
+
+	// The quota might have been lowered since the last run.
+	evict (String ());
+	saveManifest ();
+}
+
+void AwBitmapCache::shutdown ()
+{
+	MutexHandle handle;
+	handle.lock (&sMutex);
+
+	saveManifest ();
+	sEntries.clear ();
+	sTotalSize = 0;
+}
+
+void AwBitmapCache::setQuota (U64 bytes)
+{
+	MutexHandle handle;
+	handle.lock (&sMutex);
+
+	if (bytes == sQuota)
+	{
+		return;
+	}
+
+	sQuota = bytes;
+	evict (String ());
+	saveManifest ();
+}
+
+void AwBitmapCache::touch (const String &path)
+{
+	MutexHandle handle;
+	handle.lock (&sMutex);
+
+	// Saved with the next write or at shutdown. Losing a touch only makes eviction a little less accurate.
+	Map <String, Entry>::Iterator iter = sEntries.find (Torque::Path (path).getFullFileName ());
+	if (iter != sEntries.end ())
+	{
+		iter->value.lastUsed = Platform::getTime ();
+		sIsDirty = true;
+	}
+}
+
+void AwBitmapCache::addEntry (const String &path, U32 size)
+{
+	MutexHandle handle;
+	handle.lock (&sMutex);
+
+	String name = Torque::Path (path).getFullFileName ();
+	Map <String, Entry>::Iterator iter = sEntries.find (name);
+	if (iter != sEntries.end ())
+	{
+		sTotalSize -= iter->value.size;
+	}
+
+	Entry &entry = sEntries [name];
+	entry.size = size;
+	entry.lastUsed = Platform::getTime ();
+	sTotalSize += size;
+	sIsDirty = true;
+
+	evict (name);
+	saveManifest ();
+}
+
+void AwBitmapCache::evict (const String &keep)
+{
+	while (sQuota > 0 && sTotalSize > sQuota)
+	{
+		Map <String, Entry>::Iterator oldest = sEntries.end ();
+		for (Map <String, Entry>::Iterator iter = sEntries.begin (); iter != sEntries.end (); iter++)
+		{
+			if (iter->key != keep && (oldest == sEntries.end () || iter->value.lastUsed < oldest->value.lastUsed))
+			{
+				oldest = iter;
+			}
+		}
+
+		if (oldest == sEntries.end ())
+		{
+			return;
+		}
+
+		Torque::FS::Remove (sDirectory + "/" + oldest->key);
+		sTotalSize -= oldest->value.size;
+		sEntries.erase (oldest->key);
+		sIsDirty = true;
+	}
+}
+
+void AwBitmapCache::loadManifest ()
+{
+	sEntries.clear ();
+	sTotalSize = 0;
+	sIsDirty = false;
+
+	FileStream stream;
+	if (!stream.open (sDirectory + "/manifest.txt", Torque::FS::File::Read))
+	{
+		return;
+	}
+
+	// One "<file name> <size> <last used>" line per entry.
+	char line [512];
+	char name [256];
+	while (stream.getStatus () == Stream::Ok)
+	{
+		stream.readLine ((U8 *)line, sizeof (line));
+
+		Entry entry;
+		if (dSscanf (line, "%255s %u %u", name, &entry.size, &entry.lastUsed) == 3)
+		{
+			sEntries.insert (name, entry);
+			sTotalSize += entry.size;
+		}
+	}
+}
+
+void AwBitmapCache::saveManifest ()
+{
+	if (!sIsDirty || sDirectory.isEmpty ())
+	{
+		return;
+	}
+
+	// Write it next to the old one and swap them, so a crash never leaves half a manifest.
+	String path = sDirectory + "/manifest.txt";
+	String tempPath = path + ".tmp";
+	FileStream stream;
+	Platform::createPath (tempPath.c_str ());
+	if (!stream.open (tempPath, Torque::FS::File::Write))
+	{
+		return;
+	}
+
+	char line [512];
+	for (Map <String, Entry>::Iterator iter = sEntries.begin (); iter != sEntries.end (); iter++)
+	{
+		U32 length = dSprintf (line, sizeof (line), "%s %u %u\n", iter->key.c_str (), iter->value.size, iter->value.lastUsed);
+		stream.write (length, line);
+	}
+	stream.close ();
+
+	Torque::FS::Remove (path);
+	Torque::FS::Rename (tempPath, path);
+	sIsDirty = false;
+}
+
+bool AwBitmapCache::write (Stream &stream, const U8 *bits, U32 pitch, U32 width, U32 height, GFXFormat format, Format compression)
+{
+	Header header;
+	header.magic = Magic;
+	header.version = Version;
+	header.width = width;
+	header.height = height;
+	header.format = format;
+	header.compression = FormatRaw;
+	header.pitch = pitch;
+	header.payloadSize = pitch * height;
+
+	U8 *compressed = nullptr;
+	if (compression == FormatLZ4)
+	{
+		U32 capacity = AwLZ4::getMaxCompressedSize (header.payloadSize);
+		compressed = new U8 [capacity];
+		U32 size = AwLZ4::compress (bits, header.payloadSize, compressed, capacity);
+
+		// Noise doesn't compress. Store it raw then, as that loads faster.
+		if (size > 0 && size < header.payloadSize)
+		{
+			header.compression = FormatLZ4;
+			header.payloadSize = size;
+		}
+	}
+
+	const U8 *payload = header.compression == FormatLZ4 ? compressed : bits;
+	bool isWritten = stream.write (sizeof (header), &header) && stream.write (header.payloadSize, payload);
+	delete [] compressed;
+	return isWritten;
+}
+
+bool AwBitmapCache::isValid (const Header &header, U32 fileSize)
+{
+	return fileSize >= sizeof (Header) &&
+		header.magic == Magic &&
+		header.version == Version &&
+		header.width > 0 && header.width <= MaxSize &&
+		header.height > 0 && header.height <= MaxSize &&
+		header.pitch == header.width * 4 &&
+		header.payloadSize == fileSize - sizeof (Header) &&
+		(header.compression == FormatLZ4 || (header.compression == FormatRaw && header.payloadSize == header.pitch * header.height));
+}
+
+bool AwBitmapCache::canDecode (const String &path, GFXFormat textureFormat)
+{
+	AwMappedFile file;
+	if (!file.open (path) || file.getSize () < sizeof (Header))
+	{
+		return false;
+	}
+
+	const Header &header = *(const Header *)file.getData ();
+	return isValid (header, file.getSize ()) && header.format == (U32)textureFormat;
+}
+
+const U8 *AwBitmapCache::decode (const String &path, GFXFormat textureFormat, Header &header, AwMappedFile &file, U8 *&buffer)
+{
+	buffer = nullptr;
+	if (!file.open (path) || file.getSize () < sizeof (Header))
+	{
+		file.close ();
+		return nullptr;
+	}
+
+	header = *(const Header *)file.getData ();
+	if (!isValid (header, file.getSize ()) || header.format != (U32)textureFormat)
+	{
+		// Left for the next write job to replace. This runs on a worker, and deleting here would pull the file from under the manifest.
+		file.close ();
+		return nullptr;
+	}
+
+	const U8 *payload = file.getData () + sizeof (Header);
+	if (header.compression == FormatRaw)
+	{
+		// Raw pixels are uploaded straight from the mapping. Touch every page here, so the disk is read on the worker and not while the
+		// texture is locked on the main thread.
+		volatile U8 sum = 0;
+		for (U32 i = 0; i < header.payloadSize; i += 4096)
+		{
+			sum += payload [i];
+		}
+
+		return payload;
+	}
+
+	// Only LZ4 files need a buffer of their own. The mapping isn't needed anymore once they're decompressed.
+	U32 unpackedSize = header.pitch * header.height;
+	buffer = new U8 [unpackedSize];
+	bool isDecompressed = AwLZ4::decompress (payload, header.payloadSize, buffer, unpackedSize);
+	file.close ();
+	if (!isDecompressed)
+	{
+		delete [] buffer;
+		buffer = nullptr;
+	}
+
+	return buffer;
+}
+
+bool AwBitmapCache::upload (const Header &header, const U8 *pixels, GFXTexHandle &texture)
+{
+	GFXTexHandle result = GFX->getTextureManager ()->createTexture (header.width, header.height, (GFXFormat)header.format, &GFXDefaultStaticDiffuseProfile, 1, 0);
+	GFXLockedRect *rect = result.isValid () ? result.lock () : nullptr;
+	if (!rect)
+	{
+		return false;
+	}
+
+	U32 rowSize = header.width * 4;
+	if (rect->pitch == header.pitch)
+	{
+		dMemcpy (rect->bits, pixels, header.pitch * header.height);
+	}
+	else
+	{
+		for (U32 y = 0; y < header.height; y++)
+		{
+			dMemcpy (rect->bits + (y * rect->pitch), pixels + (y * header.pitch), rowSize);
+		}
+	}
+
+	result.unlock ();
+	texture = result;
+	return true;
+}
\ No newline at end of file
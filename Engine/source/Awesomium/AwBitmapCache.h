@@ -0,0 +1,111 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Platform/Types.h"
+#include "GFX/gfxEnums.h"
+#include "GFX/GFXTextureHandle.h"
+#include "Core/Util/TDictionary.h"
+#include "math/mPoint2.h"
+#include "platform/threads/mutex.h"
+
+class Stream;
+class AwMappedFile;
+
+/*
+ *  AwBitmapCache
+ *  -----------------------------------------------------------------------------------------------
+ *	Reads and writes the .awc bitmap cache format: a fixed header followed by the pixels in the
+ *	layout of Awesomium textures, either raw or LZ4 compressed. Decoding maps the file on a worker,
+ *	without any image decoding. Raw pixels are uploaded straight from the mapping, and only LZ4
+ *	files are decompressed into a buffer first. Either way, the upload is a plain copy into the
+ *	locked texture. The texture layout is
+ *	part of the file name, so devices with different layouts keep separate files.
+ *
+ *	Cache files are named after a hash of everything the snapshot depends on (see makeKey ()), so
+ *	a changed page gets a new file instead of showing a stale one, and targets showing the same
+ *	page share a file. A manifest in the cache directory tracks the size and last use of every
+ *	file, and the least recently used ones are deleted once the files exceed the quota. The
+ *	manifest is shared with the write jobs, so it's guarded by a mutex.
+ */
+class AwBitmapCache
+{
+public:
+	enum Format
+	{
+		FormatPNG,											// Portable, but slow to load.
+		FormatRaw,											// Largest, but loads with a plain copy.
+		FormatLZ4,											// Raw pixels compressed with LZ4. Decompresses at memory speed.
+		NumFormats
+	};
+
+	struct Header
+	{
+		U32 magic;											// Always Magic.
+		U32 version;										// Always Version.
+		U32 width;
+		U32 height;
+		U32 format;											// The GFXFormat of the pixels.
+		U32 compression;									// FormatRaw or FormatLZ4.
+		U32 pitch;											// Bytes per row of the uncompressed pixels.
+		U32 payloadSize;									// Bytes of pixel data following the header.
+	};
+
+	enum
+	{
+		Magic = 0x31435741,									// "AWC1"
+		Version = 1,
+		MaxSize = 16384										// Larger sizes are treated as damage.
+	};
+
+private:
+	struct Entry
+	{
+		U32 size;											// Bytes on disk.
+		U32 lastUsed;										// When the file was last written or loaded, in seconds (see Platform::getTime).
+	};
+
+	static Mutex sMutex;									// Guards everything below.
+	static Map <String, Entry> sEntries;					// The manifest, by file name.
+	static String sDirectory;								// Where managed cache files live.
+	static U64 sTotalSize;									// The sum of all entry sizes.
+	static U64 sQuota;										// Bytes the files may take before the least recently used ones are deleted.
+	static bool sIsDirty;									// Set when the manifest has changes which haven't been saved.
+
+	static void loadManifest ();
+	static void saveManifest ();							// Writes the manifest if it has changed. Requires sMutex to be held.
+	static void evict (const String &keep);					// Deletes the least recently used files until the quota is met. Requires sMutex to be held.
+	static bool isValid (const Header &header, U32 fileSize); // Checks a header against the size of its file.
+
+public:
+	static const char *getExtension (Format format) { return format == FormatPNG ? "png" : "awc"; }
+	static String makeKey (const String &url, const Point2I &resolution, bool isTransparent, const String &version); // Hashes everything a snapshot depends on into a file name stem.
+	static String getPath (const String &key, Format format); // Returns where the cache file for the key is kept. Call on the main thread, .awc paths depend on the texture layout.
+	static void init (const String &directory);				// Sets the cache directory and reads its manifest.
+	static void shutdown ();								// Saves the manifest.
+	static void setQuota (U64 bytes);
+	static void touch (const String &path);					// Marks the file as used, so it's evicted last. Call when it has been loaded.
+	static void addEntry (const String &path, U32 size);	// Records a newly written file and evicts others if needed. Called from the write jobs.
+	static bool write (Stream &stream, const U8 *bits, U32 pitch, U32 width, U32 height, GFXFormat format, Format compression); // Writes the pixels, which have to be in the given texture format already.
+	static bool canDecode (const String &path, GFXFormat textureFormat); // Reads only the header to tell whether decode () would succeed. Safe to call from workers.
+	static const U8 *decode (const String &path, GFXFormat textureFormat, Header &header, AwMappedFile &file, U8 *&buffer); // Returns the pixels in the texture layout, or null if the file is missing, damaged or in another format. Raw pixels point into the mapped file, LZ4 ones into a new buffer. Both have to be kept until the upload. Never deletes the file. Safe to call from workers.
+	static bool upload (const Header &header, const U8 *pixels, GFXTexHandle &texture); // Creates the texture from decoded pixels. Call on the main thread.
+};
\ No newline at end of file
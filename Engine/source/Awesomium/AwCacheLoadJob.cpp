@@ -0,0 +1,98 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwCacheLoadJob.h"
+#include "AwManager.h"
+#include "gfx/bitmap/gBitmap.h"
+#include "core/stream/fileStream.h"
+#include "core/volume.h"
+
+AwCacheLoadJob::AwCacheLoadJob (const String &rawPath, const String &bitmapPath)
+{
+	mRawPath = rawPath;
+	mBitmapPath = bitmapPath;
+	mBuffer = nullptr;
+	mPixels = nullptr;
+	mBitmap = nullptr;
+
+	// Negotiating the format touches the device, so it can't happen on the worker.
+	mTextureFormat = AwManager::getTextureFormat ();
+}
+
+AwCacheLoadJob::~AwCacheLoadJob ()
+{
+	delete [] mBuffer;
+	delete mBitmap;
+}
+
+void AwCacheLoadJob::run ()
+{
+	mPixels = AwBitmapCache::decode (mRawPath, mTextureFormat, mHeader, mFile, mBuffer);
+	if (mPixels)
+	{
+		AwBitmapCache::touch (mRawPath);
+		return;
+	}
+
+	if (!Torque::FS::IsFile (mBitmapPath))
+	{
+		return;
+	}
+
+	FileStream stream;
+	if (!stream.open (mBitmapPath, Torque::FS::File::Read))
+	{
+		return;
+	}
+
+	GBitmap *bitmap = new GBitmap;
+	if (!bitmap->readBitmap ("png", stream))
+	{
+		delete bitmap;
+		return;
+	}
+
+	mBitmap = bitmap;
+	AwBitmapCache::touch (mBitmapPath);
+}
+
+bool AwCacheLoadJob::upload (GFXTexHandle &texture)
+{
+	if (mPixels)
+	{
+		// The pixels are only needed once, so let go of the mapping or buffer right away.
+		bool isUploaded = AwBitmapCache::upload (mHeader, mPixels, texture);
+		mPixels = nullptr;
+		mFile.close ();
+		delete [] mBuffer;
+		mBuffer = nullptr;
+		return isUploaded;
+	}
+
+	if (mBitmap)
+	{
+		// The texture manager takes over the bitmap.
+		GBitmap *bitmap = mBitmap;
+		mBitmap = nullptr;
+		return texture.set (bitmap, &GFXDefaultStaticDiffuseProfile, true, mBitmapPath);
+	}
+
+	return false;
+}
\ No newline at end of file
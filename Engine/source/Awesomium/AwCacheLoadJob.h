@@ -0,0 +1,56 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "AwJob.h"
+#include "AwBitmapCache.h"
+#include "AwMappedFile.h"
+#include "core/util/str.h"
+
+class GBitmap;
+
+/*
+ *  AwCacheLoadJob
+ *  -----------------------------------------------------------------------------------------------
+ *	Reads and decodes a target's bitmap cache file on a worker thread. The .awc file is preferred,
+ *	and the PNG is decoded if there's none. Only the texture creation is left to the main thread,
+ *	where AwCacheLoader uploads all finished jobs together.
+ */
+class AwCacheLoadJob : public AwJob
+{
+	String mRawPath;										// The .awc file.
+	String mBitmapPath;										// The PNG file, used if the .awc file can't be.
+	GFXFormat mTextureFormat;								// .awc files in another layout are rejected.
+	AwBitmapCache::Header mHeader;							// Describes mPixels.
+	AwMappedFile mFile;										// The .awc file. Kept mapped until the upload, since raw pixels are uploaded straight from it.
+	U8 *mBuffer;											// The decompressed pixels of an LZ4 .awc file. Owned by the job.
+	const U8 *mPixels;										// The pixels of the .awc file in the texture layout, in mFile or mBuffer.
+	GBitmap *mBitmap;										// The decoded PNG file. Owned by the job until it's uploaded.
+
+protected:
+	virtual void run ();
+
+public:
+	AwCacheLoadJob (const String &rawPath, const String &bitmapPath); // Call on the main thread.
+	~AwCacheLoadJob ();
+
+	bool upload (GFXTexHandle &texture);					// Creates the texture from whatever was decoded. Returns false if there was no usable file. Only valid once the job is done.
+};
\ No newline at end of file
@@ -0,0 +1,71 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwCacheLoader.h"
+#include "AwTextureTarget.h"
+#include "platform/platform.h"
+
+Vector <AwCacheLoader::Load> AwCacheLoader::sLoads;
+
+ThreadSafeRef <AwCacheLoadJob> AwCacheLoader::queue (AwTextureTarget *target, const String &rawPath, const String &bitmapPath)
+{
+	Load load;
+	load.target = target;
+	load.job = new AwCacheLoadJob (rawPath, bitmapPath);
+	load.job->queue ();
+	sLoads.push_back (load);
+	return load.job;
+}
+
+void AwCacheLoader::process ()
+{
+	if (isDone ())
+	{
+		return;
+	}
+
+	for (U32 i = 0; i < sLoads.size ();)
+	{
+		Load &load = sLoads [i];
+		if (load.target && !load.job->isDone ())
+		{
+			i++;
+			continue;
+		}
+
+		// A job whose target is gone owns everything it needs, so it's simply let go.
+		if (load.target)
+		{
+			load.target->finishCacheLoad (load.job);
+		}
+		sLoads.erase (i);
+	}
+}
+
+void AwCacheLoader::cancel ()
+{
+	// The jobs update the cache manifest, so don't let them outlive it.
+	for (U32 i = 0; i < sLoads.size (); i++)
+	{
+		sLoads [i].job->wait ();
+	}
+
+	sLoads.clear ();
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Core/Util/tVector.h"
+#include "console/simObject.h"
+#include "AwCacheLoadJob.h"
+
+class AwTextureTarget;
+
+/*
+ *  AwCacheLoader
+ *  -----------------------------------------------------------------------------------------------
+ *	Loads the bitmap cache files of targets in batches. While a mission loads, every target which
+ *	gets its first shape queues its file here instead of loading it on the spot, and the files are
+ *	read and decoded in parallel on the global thread pool. At the start of each frame, all loads
+ *	which have been decoded are uploaded in one pass, so the textures of a level arrive together
+ *	instead of one synchronous decode at a time. Driven by AwManager.
+ */
+class AwCacheLoader
+{
+	struct Load
+	{
+		SimObjectPtr <AwTextureTarget> target;
+		ThreadSafeRef <AwCacheLoadJob> job;
+	};
+
+	static Vector <Load> sLoads;							// Loads which haven't been uploaded yet, in the order they were queued.
+
+public:
+	static ThreadSafeRef <AwCacheLoadJob> queue (AwTextureTarget *target, const String &rawPath, const String &bitmapPath); // Starts decoding the target's cache file. The target is handed the job again once it's uploaded.
+	static void process ();									// Uploads all loads which have been decoded. Called once per frame.
+	static bool isDone () { return sLoads.empty (); }
+	static void cancel ();									// Waits for the jobs in flight and drops all loads.
+};
\ No newline at end of file
@@ -0,0 +1,108 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwCacheWriteJob.h"
+#include "AwManager.h"
+#include "gfx/bitmap/gBitmap.h"
+#include "core/stream/fileStream.h"
+#include "core/volume.h"
+
+U32 AwCacheWriteJob::sNextJobNumber											= 0;
+
+AwCacheWriteJob::AwCacheWriteJob (GBitmap *bitmap, const String &path, AwBitmapCache::Format format, bool isManaged)
+{
+	mBitmap = bitmap;
+	mPath = path;
+	mFormat = format;
+	mIsManaged = isManaged;
+
+	// Targets showing the same page and the prerenderer can write the same path at the same time, so each job needs a temporary file of its own.
+	mTempPath = mPath + String::ToString (".%u.tmp", sNextJobNumber++);
+
+	// The bitmap is RGBA. The texture layout is BGRA, unless the device forced us to swizzle.
+	mTextureFormat = AwManager::getTextureFormat ();
+	mCopyMode = AwManager::getTextureCopyMode () == AwPixelCopy::Copy ? AwPixelCopy::SwapRB : AwPixelCopy::Copy;
+}
+
+AwCacheWriteJob::~AwCacheWriteJob ()
+{
+	delete mBitmap;
+}
+
+void AwCacheWriteJob::run ()
+{
+	// Another target showing the same page may have written the file already. An .awc file which can't be loaded (damaged, or a forced
+	// filename written with another texture layout) is replaced instead.
+	bool isReplacing = false;
+	if (Torque::FS::IsFile (mPath))
+	{
+		if (mFormat == AwBitmapCache::FormatPNG || AwBitmapCache::canDecode (mPath, mTextureFormat))
+		{
+			return;
+		}
+
+		isReplacing = true;
+	}
+
+	FileStream stream;
+	Platform::createPath (mTempPath.c_str ());
+	if (!stream.open (mTempPath, Torque::FS::File::Write))
+	{
+		return;
+	}
+
+	bool isWritten;
+	if (mFormat == AwBitmapCache::FormatPNG)
+	{
+		isWritten = mBitmap->writeBitmap ("png", stream);
+	}
+	else
+	{
+		U32 width = mBitmap->getWidth ();
+		U32 height = mBitmap->getHeight ();
+		U8 *pixels = new U8 [width * height * 4];
+		AwPixelCopy::RowFunc copyRow = AwPixelCopy::getRowFunc (mCopyMode);
+		for (U32 y = 0; y < height; y++)
+		{
+			copyRow (pixels + (y * width * 4), mBitmap->getBits () + (y * width * 4), width);
+		}
+
+		isWritten = AwBitmapCache::write (stream, pixels, width * 4, width, height, mTextureFormat, mFormat);
+		delete [] pixels;
+	}
+	U32 size = stream.getPosition ();
+	stream.close ();
+
+	if (isWritten && isReplacing)
+	{
+		Torque::FS::Remove (mPath);
+	}
+
+	if (!isWritten || !Torque::FS::Rename (mTempPath, mPath))
+	{
+		Torque::FS::Remove (mTempPath);
+		return;
+	}
+
+	if (mIsManaged)
+	{
+		AwBitmapCache::addEntry (mPath, size);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "AwJob.h"
+#include "AwBitmapCache.h"
+#include "AwPixelCopy.h"
+#include "core/util/str.h"
+
+class GBitmap;
+
+/*
+ *  AwCacheWriteJob
+ *  -----------------------------------------------------------------------------------------------
+ *	Writes a snapshot of a page to the bitmap cache on a worker thread, so the encode and the file
+ *	I/O never stall a frame. Writes PNG or, for the .awc formats, the pixels in the texture layout.
+ *	The file is written under a temporary name of its own and renamed once it's complete, so a
+ *	reader never sees half a file, even with several jobs writing the same page. Nothing is written
+ *	if a usable file already exists.
+ */
+class AwCacheWriteJob : public AwJob
+{
+	GBitmap *mBitmap;										// The snapshot, in GFXFormatR8G8B8A8. Owned by the job.
+	String mPath;											// Where the bitmap ends up.
+	String mTempPath;										// Where the bitmap is written until it's complete. Unique per job.
+	AwBitmapCache::Format mFormat;
+	GFXFormat mTextureFormat;								// The layout .awc files store the pixels in.
+	AwPixelCopy::CopyMode mCopyMode;						// How to get from the bitmap's RGBA to mTextureFormat.
+	bool mIsManaged;										// Set if the file is tracked by the AwBitmapCache manifest.
+
+	static U32 sNextJobNumber;								// Makes the temporary file names unique. Only touched on the main thread.
+
+protected:
+	virtual void run ();
+
+public:
+	AwCacheWriteJob (GBitmap *bitmap, const String &path, AwBitmapCache::Format format, bool isManaged); // Takes ownership of the bitmap. Call on the main thread.
+	~AwCacheWriteJob ();
+};
\ No newline at end of file
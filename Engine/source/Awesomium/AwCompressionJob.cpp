@@ -0,0 +1,69 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwCompressionJob.h"
+#include "gfx/bitmap/gBitmap.h"
+#include "gfx/bitmap/ddsFile.h"
+#include "gfx/bitmap/ddsUtils.h"
+
+AwCompressionJob::AwCompressionJob (GBitmap *bitmap)
+{
+	mBitmap = bitmap;
+	mResult = nullptr;
+}
+
+AwCompressionJob::~AwCompressionJob ()
+{
+	delete mBitmap;
+	delete mResult;
+}
+
+void AwCompressionJob::run ()
+{
+	// DXT1 only has a single bit of alpha, so use it only if the page is fully opaque.
+	const U8 *bits = mBitmap->getBits ();
+	U32 numPixels = mBitmap->getWidth () * mBitmap->getHeight ();
+	bool isOpaque = true;
+	for (U32 i = 0; i < numPixels && isOpaque; i++)
+	{
+		isOpaque = bits [(i * 4) + 3] == 255;
+	}
+
+	DDSFile *dds = DDSFile::createDDSFileFromGBitmap (mBitmap);
+	if (!dds)
+	{
+		return;
+	}
+
+	if (!DDSUtil::squishDDS (dds, isOpaque ? GFXFormatDXT1 : GFXFormatDXT5))
+	{
+		delete dds;
+		return;
+	}
+
+	mResult = dds;
+}
+
+DDSFile *AwCompressionJob::takeResult ()
+{
+	DDSFile *result = mResult;
+	mResult = nullptr;
+	return result;
+}
\ No newline at end of file
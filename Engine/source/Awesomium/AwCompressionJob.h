@@ -0,0 +1,48 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "AwJob.h"
+
+class GBitmap;
+struct DDSFile;
+
+/*
+ *  AwCompressionJob
+ *  -----------------------------------------------------------------------------------------------
+ *	Block-compresses a snapshot of a page on a worker thread. Pages without any transparent pixels
+ *	become DXT1 (BC1), the rest become DXT5 (BC3). Used by AwTextureTarget for targets which rarely
+ *	or never change, so they take a quarter to an eighth of the video memory.
+ */
+class AwCompressionJob : public AwJob
+{
+	GBitmap *mBitmap;										// The snapshot, in GFXFormatR8G8B8A8. Owned by the job.
+	DDSFile *mResult;										// The compressed texture, once the job is done.
+
+protected:
+	virtual void run ();
+
+public:
+	AwCompressionJob (GBitmap *bitmap);						// Takes ownership of the bitmap.
+	~AwCompressionJob ();
+
+	DDSFile *takeResult ();									// Returns the compressed texture and hands over ownership. Only valid once the job is done.
+};
\ No newline at end of file
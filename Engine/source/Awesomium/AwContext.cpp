@@ -20,6 +20,9 @@
 
 #include "AwContext.h"
 #include "AwManager.h"
+#include "AwSurface.h"
+#include "AwPixelCopy.h"
+#include "AwTexturePool.h"
 #include "Core/Stream/FileStream.h"
 #include "GFX/GFXTextureManager.h"
 
@@ -33,49 +36,121 @@ AwContext::AwContext ()
 	mCursorRenderPos.set (0, 0);
 	mShowCursor = false;
 	mIsJavaScriptReady = false;
+	mIsSavingState = false;
 	mRenderedCursorLastFrame = false;
+	mIsCursorOverlay = false;
+	mDirtyAreaRatio = 0.0f;
+	mTexturesEnabled = true;
+	mFrameNumber = 0;
+	mTextureRingDepth = 1;
+	mCurrentTexture = 0;
+	mResolution.set (0, 0);
+	mPendingResolution.set (0, 0);
+	mPendingResolutionTime = 0;
+	mHasPendingResolution = false;
+	mAllowPaddedTextures = false;
+	mIsUpdating = false;
 	mCursorBitmap = GBitmap::load ("Awesomium/defaultCursor.png");
 }
 
 AwContext::~AwContext ()
 {
+	cancelUpdate ();
+	releaseRing ();
+
 	if (mView)
 	{
 		mView->Destroy ();
 	}
 }
 
-void AwContext::blitCursorToTexture (GFXLockedRect *rect)
+RectI AwContext::getCursorRect (const Point2I &pos)
+{
+	if (!mCursorBitmap)
+	{
+		return RectI (pos.x, pos.y, 0, 0);
+	}
+
+	return RectI (pos.x, pos.y, mCursorBitmap->getWidth (), mCursorBitmap->getHeight ());
+}
+
+AwSurface *AwContext::getSurface ()
+{
+	return mView ? (AwSurface *)mView->surface () : nullptr;
+}
+
+AwCursorJob::AwCursorJob (const U8 *page, U32 pagePitch, const RectI &area)
+{
+	mArea = area;
+	mPixels = new U8 [area.extent.x * area.extent.y * 4];
+	mCopyMode = AwPixelCopy::Copy;
+	mCursorBitmap = nullptr;
+
+	U32 rowSize = area.extent.x * 4;
+	for (S32 y = 0; y < area.extent.y; y++)
+	{
+		dMemcpy (mPixels + (y * rowSize), page + ((area.point.y + y) * pagePitch) + (area.point.x * 4), rowSize);
+	}
+}
+
+void AwCursorJob::run ()
 {
 	// We only support bitmaps with alpha.
-	if (mCursorBitmap->getBytesPerPixel () != 4)
+	if (!mCursorBitmap || mCursorBitmap->getBytesPerPixel () != 4)
 	{
 		return;
 	}
 
+	// The cursor bitmap is RGBA. Find out where red and blue go in the texture layout.
+	U32 red = mCopyMode == AwPixelCopy::SwapRB ? 0 : 2;
+	U32 blue = 2 - red;
+
 	const U8 *bits = mCursorBitmap->getBits ();
-	for (U32 y = 0; y < mCursorBitmap->getHeight (); y++)
+	for (S32 y = 0; y < mArea.extent.y; y++)
 	{
-		for (U32 x = 0; x < mCursorBitmap->getWidth (); x++)
+		U8 *dest = mPixels + (y * mArea.extent.x * 4);
+		const U8 *cursor = bits + (((mArea.point.y + y - mCursorPos.y) * mCursorBitmap->getWidth ()) + (mArea.point.x - mCursorPos.x)) * 4;
+		for (S32 x = 0; x < mArea.extent.x; x++, dest += 4, cursor += 4)
 		{
-			U32 index = ((mCursorPos.y + y) * rect->pitch) + (mCursorPos.x + x) * mTexture->getFormatByteSize ();
-			U32 cursorIndex = (x + (y * mCursorBitmap->getWidth ())) * 4;
-
-			if ((mCursorPos.x + x) < mTexture->getWidth () && (mCursorPos.y + y) < mTexture->getHeight ())
-			{
-				F32 mod = (F32)bits [cursorIndex + 3] / 255.0f;
-				F32 invMod = 1.0f - mod;
-				rect->bits [index]			= (rect->bits [index] * invMod) + (bits [cursorIndex + 2] * mod);
-				rect->bits [index + 1]		= (rect->bits [index + 1] * invMod) + (bits [cursorIndex + 1] * mod);
-				rect->bits [index + 2]		= (rect->bits [index + 2] * invMod) + (bits [cursorIndex] * mod);
-				rect->bits [index + 3]		= (rect->bits [index + 3] * invMod) + (bits [cursorIndex + 3] * mod);
-			}
+			U32 alpha = cursor [3];
+			U32 invAlpha = 255 - alpha;
+			dest [red]		= ((dest [red] * invAlpha) + (cursor [0] * alpha) + 127) / 255;
+			dest [1]		= ((dest [1] * invAlpha) + (cursor [1] * alpha) + 127) / 255;
+			dest [blue]		= ((dest [blue] * invAlpha) + (cursor [2] * alpha) + 127) / 255;
+			dest [3]		= ((dest [3] * invAlpha) + (cursor [3] * alpha) + 127) / 255;
 		}
 	}
 }
 
-void AwContext::copyToTexture ()
+void AwContext::beginUpdate ()
 {
+	// A paused context keeps its pending resolution until it resumes. Resizing recreates the ring, and a paused target is still drawn while it
+	// comes back into view, so it would show empty textures instead of its last frame until the resize was uploaded.
+	if (mIsPaused)
+	{
+		return;
+	}
+
+	if (mHasPendingResolution && mPendingResolutionTime + AwManager::getResizeDelay () <= Platform::getRealMilliseconds ())
+	{
+		applyResolution (mPendingResolution);
+	}
+
+	if (mIsUpdating)
+	{
+		return;
+	}
+
+	if (mFrameNumber > 0 && mNextUpdateTime >= Platform::getRealMilliseconds ())
+	{
+		return;
+	}
+
+	if (mFramerate > 0)
+	{
+		mNextUpdateTime = Platform::getRealMilliseconds () + (1000.0f / (F32)mFramerate);
+	}
+
 	// If the view has crashed, destroy it. We'll recreate it below.
 	if (mView && mView->IsCrashed ())
 	{
@@ -85,72 +160,267 @@ void AwContext::copyToTexture ()
 		initView ();
 	}
 
-	Awesomium::BitmapSurface *surface = mView ? (Awesomium::BitmapSurface *)mView->surface () : nullptr;
-	
-	// Check if we really need to redraw.
-	if (surface && (surface->is_dirty () || mCursorPos != mCursorRenderPos || mRenderedCursorLastFrame != mShowCursor))
+	AwSurface *surface = getSurface ();
+	if (!surface || mResolution.isZero ())
+	{
+		return;
+	}
+
+	// A device reset may have picked another texture format since the surface was created.
+	surface->setCopyMode (AwManager::getTextureCopyMode ());
+
+	// Collect what Awesomium has painted since the last update.
+	AwDirtyRegion region;
+	surface->takeDirtyRegion (region);
+
+	// The cursor has to be redrawn both where it was and where it is now.
+	bool drawCursor = mShowCursor && mCursorBitmap && !mIsCursorOverlay;
+	if (mCursorPos != mCursorRenderPos || mRenderedCursorLastFrame != drawCursor)
 	{
-		if (surface)
+		if (mRenderedCursorLastFrame)
+		{
+			region.add (getCursorRect (mCursorRenderPos));
+		}
+		if (drawCursor)
 		{
-			surface->set_is_dirty (false);
+			region.add (getCursorRect (mCursorPos));
 		}
-		
-		GFXLockedRect *rect = mTexture.lock ();
+	}
+	mCursorRenderPos = mCursorPos;
+	mRenderedCursorLastFrame = drawCursor;
+
+	// When we resize the Awesomium surface, this can take a while as it's asynchronous.
+	// Until then we only upload the area the surface and the texture have in common.
+	Point2I size (getMin (mResolution.x, surface->getWidth ()), getMin (mResolution.y, surface->getHeight ()));
+	region.clip (size);
+	if (region.isEmpty ())
+	{
+		return;
+	}
+
+	mUpdateRegion = region;
+	mIsUpdating = true;
+
+	// The surface is already in the texture layout. Only the cursor is left to composite.
+	RectI cursorRect = getCursorRect (mCursorPos);
+	if (!drawCursor || !cursorRect.intersect (RectI (Point2I (0, 0), size)))
+	{
+		mCursorPatch = nullptr;
+		return;
+	}
+
+	mCursorJob = new AwCursorJob (surface->getBuffer (), surface->getPitch (), cursorRect);
+	mCursorJob->mCopyMode = AwManager::getTextureCopyMode ();
+	mCursorJob->mCursorBitmap = (GBitmap *)mCursorBitmap;
+	mCursorJob->mCursorPos = mCursorPos;
+	mCursorJob->queue ();
+}
 
-		// When we resize the Awesomium surface, this can take a while as it's asynchronous.
-		// In this case we have to take a different approach when we blit the texture.
-		//if (mTexture.getHeight () != surface->height () || mTexture.getWidth () != surface->width ())
+bool AwContext::isUpdateDue ()
+{
+	if (mIsPaused || mIsUpdating || !mView)
+	{
+		return false;
+	}
+
+	return mFrameNumber == 0 || mNextUpdateTime < Platform::getRealMilliseconds ();
+}
+
+U32 AwContext::getPendingUploadBytes ()
+{
+	if (!mTexturesEnabled || mResolution.isZero ())
+	{
+		return 0;
+	}
+
+	AwDirtyRegion region = mPendingRegions [(mCurrentTexture + 1) % mTextureRingDepth];
+	if (isUpdateReady ())
+	{
+		region.add (mUpdateRegion);
+	}
+
+	return region.getArea () * 4;
+}
+
+void AwContext::finishUpdate ()
+{
+	if (!mIsUpdating)
+	{
+		return;
+	}
+
+	if (mCursorJob)
+	{
+		mCursorJob->wait ();
+		mCursorPatch = mCursorJob;
+		mCursorJob = nullptr;
+	}
+
+	// Every texture in the ring is now out of date in these regions.
+	for (U32 i = 0; i < mTextureRingDepth; i++)
+	{
+		mPendingRegions [i].add (mUpdateRegion);
+	}
+	mUpdateRegion.clear ();
+	mIsUpdating = false;
+	mFrameNumber++;
+
+	if (mTexturesEnabled)
+	{
+		copyToTexture ();
+	}
+}
+
+void AwContext::copyToTexture ()
+{
+	// Fill the texture which was completed the longest time ago. The GPU is the least likely to still be reading it.
+	U8 next = (mCurrentTexture + 1) % mTextureRingDepth;
+	GFXTexHandle &texture = mTextures [next];
+	AwDirtyRegion &region = mPendingRegions [next];
+
+	AwSurface *surface = getSurface ();
+	if (region.isEmpty () || !surface)
+	{
+		mDirtyAreaRatio = 0.0f;
+		return;
+	}
+
+	// The surface already holds the pixels in the texture's layout, so this is a plain copy.
+	AwPixelCopy::BlitFunc blit = AwPixelCopy::getBlitFunc (texture->getFormat (), AwPixelCopy::Copy);
+	if (!blit)
+	{
+		Con::errorf ("AwContext::copyToTexture - Unsupported texture format %i", texture->getFormat ());
+		return;
+	}
+
+	// Upload each changed rectangle with its own sub-rect lock, and the cursor over the parts it covers.
+	RectI bounds (0, 0, getMin (mResolution.x, surface->getWidth ()), getMin (mResolution.y, surface->getHeight ()));
+	const Vector <RectI> &rects = region.getRects ();
+	for (U32 i = 0; i < rects.size (); i++)
+	{
+		RectI lockRect = rects [i];
+		GFXLockedRect *rect = lockRect.intersect (bounds) ? texture.lock (0, &lockRect) : nullptr;
+		if (!rect)
 		{
-			U32 smallestWidth = mTexture.getWidth ();
-			if (surface->width () < smallestWidth)
-			{
-				smallestWidth = surface->width ();
-			}
-			U32 smallestHeight = mTexture.getHeight ();
-			if (surface->height () < smallestHeight)
-			{
-				smallestHeight = surface->height ();
-			}
-			for (U32 y = 0; y < smallestHeight; y++)
-			{
-				for (U32 x = 0; x < smallestWidth; x++)
-				{
-					U32 targetIndex = ((y * mTexture.getWidth ()) + x) * 4;
-					U32 sourceIndex = ((y * surface->width ()) + x) * 4;
-               if (GFX->getAdapterType() == OpenGL)
-               {
-                  rect->bits[targetIndex] = surface->buffer()[sourceIndex+2]; //swizzle
-                  rect->bits[targetIndex + 1] = surface->buffer()[sourceIndex + 1];
-                  rect->bits[targetIndex + 2] = surface->buffer()[sourceIndex]; //swizzle
-                  rect->bits[targetIndex + 3] = surface->buffer()[sourceIndex + 3];
-               }
-               else
-               {
-                  rect->bits[targetIndex] = surface->buffer()[sourceIndex];
-                  rect->bits[targetIndex + 1] = surface->buffer()[sourceIndex + 1];
-                  rect->bits[targetIndex + 2] = surface->buffer()[sourceIndex + 2];
-                  rect->bits[targetIndex + 3] = surface->buffer()[sourceIndex + 3];
-               }
-				}
-			}
+			continue;
 		}
-      /*
-		else
+
+		const U8 *source = surface->getBuffer () + (lockRect.point.y * surface->getPitch ()) + (lockRect.point.x * 4);
+		blit (rect->bits, rect->pitch, source, surface->getPitch (), lockRect.extent.x, lockRect.extent.y);
+		texture.unlock ();
+
+		RectI cursorRect = mCursorPatch ? mCursorPatch->mArea : RectI ();
+		if (!mCursorPatch || !cursorRect.intersect (lockRect))
+		{
+			continue;
+		}
+
+		rect = texture.lock (0, &cursorRect);
+		if (rect)
+		{
+			U32 patchPitch = mCursorPatch->mArea.extent.x * 4;
+			const U8 *patch = mCursorPatch->mPixels + ((cursorRect.point.y - mCursorPatch->mArea.point.y) * patchPitch) + ((cursorRect.point.x - mCursorPatch->mArea.point.x) * 4);
+			blit (rect->bits, rect->pitch, patch, patchPitch, cursorRect.extent.x, cursorRect.extent.y);
+			texture.unlock ();
+		}
+	}
+
+	mDirtyAreaRatio = (F32)region.getArea () / (F32)(mResolution.x * mResolution.y);
+	region.clear ();
+	mCurrentTexture = next;
+}
+
+void AwContext::cancelUpdate ()
+{
+	if (mCursorJob)
+	{
+		mCursorJob->wait ();
+		mCursorJob = nullptr;
+	}
+
+	mCursorPatch = nullptr;
+	mUpdateRegion.clear ();
+	mIsUpdating = false;
+}
+
+void AwContext::createTextures ()
+{
+	// The update in flight was collected for the old size.
+	cancelUpdate ();
+
+	// The surface has to be uploaded again in full.
+	mRenderedCursorLastFrame = false;
+	AwSurface *surface = getSurface ();
+	if (surface)
+	{
+		surface->invalidate ();
+	}
+
+	createRing ();
+}
+
+void AwContext::createRing ()
+{
+	releaseRing ();
+	for (U32 i = 0; i < MaxTextureRingDepth; i++)
+	{
+		mPendingRegions [i].clear ();
+		if (i < mTextureRingDepth && !mResolution.isZero () && mTexturesEnabled)
 		{
-			memcpy (rect->bits, surface->buffer (), mTexture.getHeight () * mTexture.getWidth () * 4);
+			mTextures [i] = AwTexturePool::acquire (mResolution, AwManager::getTextureFormat (), mAllowPaddedTextures);
+
+			// The new texture is empty, so everything has to be uploaded.
+			mPendingRegions [i].add (RectI (0, 0, mResolution.x, mResolution.y));
 		}
-      else
-         surface->CopyTo(rect->bits, mTexture.getHeight()*mTexture.getWidth(), mTexture.getDepth(), true, false);
-      */
-		if (mShowCursor && mCursorBitmap)
+		else
 		{
-			mCursorRenderPos = mCursorPos;
-			blitCursorToTexture (rect);
-			mRenderedCursorLastFrame = mShowCursor;
+			mTextures [i] = nullptr;
 		}
+	}
+
+	mCurrentTexture = 0;
+}
+
+void AwContext::releaseRing ()
+{
+	for (U32 i = 0; i < MaxTextureRingDepth; i++)
+	{
+		AwTexturePool::release (mTextures [i]);
+	}
+}
+
+void AwContext::setTexturesEnabled (bool enabled)
+{
+	if (enabled == mTexturesEnabled)
+	{
+		return;
+	}
+
+	finishUpdate ();
+	mTexturesEnabled = enabled;
+
+	// The surface is kept up to date either way, so new textures only need a full upload from it.
+	createRing ();
+}
+
+bool AwContext::copyToBitmap (GBitmap *bmp)
+{
+	finishUpdate ();
 
-		mTexture.unlock ();
+	// The surface has to be resized already, or the copy would be partly out of date.
+	AwSurface *surface = getSurface ();
+	if (!surface || surface->getWidth () != mResolution.x || surface->getHeight () != mResolution.y ||
+		bmp->getFormat () != GFXFormatR8G8B8A8 || bmp->getWidth () != mResolution.x || bmp->getHeight () != mResolution.y)
+	{
+		return false;
 	}
+
+	// The surface is in the texture layout, which is BGRA unless the device forced us to swizzle.
+	surface->setCopyMode (AwManager::getTextureCopyMode ());
+	AwPixelCopy::CopyMode mode = AwManager::getTextureCopyMode () == AwPixelCopy::Copy ? AwPixelCopy::SwapRB : AwPixelCopy::Copy;
+	AwPixelCopy::BlitFunc blit = AwPixelCopy::getBlitFunc (GFXFormatR8G8B8A8, mode);
+	blit (bmp->getWritableBits (), mResolution.x * 4, surface->getBuffer (), surface->getPitch (), mResolution.x, mResolution.y);
+	return true;
 }
 
 void AwContext::OnMethodCall (Awesomium::WebView *view, unsigned int id, const Awesomium::WebString &name, const Awesomium::JSArray &inArgs)
@@ -171,12 +441,11 @@ void AwContext::OnMethodCall (Awesomium::WebView *view, unsigned int id, const A
 		return;
 	}
 
-	// Divide arguments into a list
+	// Divide arguments into a list. They can be longer than the buffer, like saved page states.
 	Vector <String> args;
 	for (U32 i = 0; i < inArgs.size (); i++)
 	{
-		inArgs [i].ToString ().ToUTF8 (buffer, sizeof (buffer));
-		args.push_back (buffer);
+		args.push_back (String (Awesomium::ToString (inArgs [i].ToString ()).c_str ()));
 	}
 
 	delegate (args);
@@ -210,6 +479,12 @@ void AwContext::OnDocumentReady (Awesomium::WebView *view, const Awesomium::WebU
 	}
 
 	mIsJavaScriptReady = true;
+
+	for (U32 i = 0; i < mScriptsWhenReady.size (); i++)
+	{
+		execJavaScript (mScriptsWhenReady [i]);
+	}
+	mScriptsWhenReady.clear ();
 }
 
 void AwContext::onTorqueScript (const Vector <String> &args)
@@ -252,6 +527,84 @@ void AwContext::execJavaScript (const String &script)
 	mView->ExecuteJavascript (awScript, Awesomium::WebString ());
 }
 
+void AwContext::execJavaScriptWhenReady (const String &script)
+{
+	if (mIsJavaScriptReady && !isLoading ())
+	{
+		execJavaScript (script);
+		return;
+	}
+
+	mScriptsWhenReady.push_back (script);
+}
+
+void AwContext::requestState (const String &script)
+{
+	mSavedState = String ();
+	mIsSavingState = mView && mIsJavaScriptReady;
+	if (!mIsSavingState)
+	{
+		return;
+	}
+
+	// Run the script through eval so its last statement is the result, like a blocking call would return it, and post that back.
+	execJavaScript ("(function (state) { TorqueScript.saveState (state === undefined || state === null ? '' : String (state)); }) (eval (" + quoteJavaScriptString (script) + "));");
+}
+
+void AwContext::onSaveState (const Vector <String> &args)
+{
+	if (!mIsSavingState)
+	{
+		return;
+	}
+
+	mSavedState = args.size () ? args [0] : String ();
+	mIsSavingState = false;
+}
+
+String AwContext::quoteJavaScriptString (const String &text)
+{
+	StringBuilder result;
+	result.append ('"');
+	const U8 *chars = (const U8 *)text.c_str ();
+	for (U32 i = 0; i < text.length (); i++)
+	{
+		U8 c = chars [i];
+		if (c == '\\' || c == '"')
+		{
+			result.append ('\\');
+			result.append ((char)c);
+		}
+		else if (c < 0x20 || c == 0x7F)
+		{
+			result.format ("\\u%04x", c);
+		}
+		else if (c == 0xE2 && i + 2 < text.length () && chars [i + 1] == 0x80 && (chars [i + 2] == 0xA8 || chars [i + 2] == 0xA9))
+		{
+			// U+2028 and U+2029 end a line in JavaScript, so they can't appear in a literal as they are.
+			result.append (chars [i + 2] == 0xA8 ? "\\u2028" : "\\u2029");
+			i += 2;
+		}
+		else
+		{
+			result.append ((char)c);
+		}
+	}
+
+	result.append ('"');
+	return result.end ();
+}
+
+String AwContext::getViewURL ()
+{
+	if (!mView || mView->url ().IsEmpty ())
+	{
+		return mCurrentURL;
+	}
+
+	return String (Awesomium::ToString (mView->url ().spec ()).c_str ());
+}
+
 void AwContext::initView ()
 {
 	if (mView)
@@ -259,13 +612,17 @@ void AwContext::initView ()
 		return;
 	}
 
-	mView = Awesomium::WebCore::instance ()->CreateWebView (mTexture.getWidth (), mTexture.getHeight (), AwManager::getSessionFromPath (mSessionPath));
+	mView = Awesomium::WebCore::instance ()->CreateWebView (mResolution.x, mResolution.y, AwManager::getSessionFromPath (mSessionPath));
 
 	// Bind to TorqueScript by default.
 	Delegate <void (const Vector <String> &)> delegate;
 	delegate.bind (this, &AwContext::onTorqueScript);
 	bindJavaScript ("TorqueScript", "call", delegate);
 
+	// Lets requestState () get its answer without blocking on the page.
+	delegate.bind (this, &AwContext::onSaveState);
+	bindJavaScript ("TorqueScript", "saveState", delegate);
+
 	mView->SetTransparent (mIsTransparent);
 	mView->set_load_listener (this);
 	mView->set_js_method_handler (this);
@@ -469,23 +826,6 @@ void AwContext::injectKeyUp (U8 key)
 	mView->InjectKeyboardEvent (kEvent);
 }
 
-void AwContext::update ()
-{
-	if (mIsPaused)
-	{
-		return;
-	}
-
-	if (!mTexture || mNextUpdateTime < Platform::getRealMilliseconds ())
-	{
-		copyToTexture ();
-		if (mFramerate > 0)
-		{
-			mNextUpdateTime = Platform::getRealMilliseconds () + (1000.0f / (F32)mFramerate);
-		}
-	}
-}
-
 bool AwContext::isLoading ()
 {
 	return mView ? mView->IsLoading () : false;
@@ -517,11 +857,37 @@ void AwContext::setFramerate (U8 framerate)
 	mFramerate = framerate;
 }
 
-void AwContext::setResolution (const Point2I &resolution)
+void AwContext::setResolution (const Point2I &resolution, bool immediate)
+{
+	// The first resolution is applied right away, there's nothing to show until then anyway.
+	if (immediate || mResolution.isZero ())
+	{
+		applyResolution (resolution);
+		return;
+	}
+
+	if (resolution == mResolution)
+	{
+		mHasPendingResolution = false;
+		return;
+	}
+
+	// Every new size restarts the delay.
+	if (!mHasPendingResolution || mPendingResolution != resolution)
+	{
+		mPendingResolution = resolution;
+		mPendingResolutionTime = Platform::getRealMilliseconds ();
+	}
+	mHasPendingResolution = true;
+}
+
+void AwContext::applyResolution (const Point2I &resolution)
 {
-	if (!mTexture || mTexture.getWidth () != resolution.x || mTexture.getHeight () != resolution.y)
+	mHasPendingResolution = false;
+	if (mResolution.isZero () || mResolution != resolution)
 	{
-		mTexture = GFX->getTextureManager()->createTexture(resolution.x, resolution.y, GFXFormatR8G8B8A8, &GFXDynamicTextureProfile, 0, 0);
+		mResolution = resolution;
+		createTextures ();
 		if (mView)
 		{
 			mView->Resize (resolution.x, resolution.y);
@@ -529,6 +895,36 @@ void AwContext::setResolution (const Point2I &resolution)
 	}
 }
 
+void AwContext::setPaddedTextures (bool allow)
+{
+	if (allow == mAllowPaddedTextures)
+	{
+		return;
+	}
+
+	mAllowPaddedTextures = allow;
+	if (!mResolution.isZero ())
+	{
+		finishUpdate ();
+		createRing ();
+	}
+}
+
+void AwContext::setTextureRingDepth (U8 depth)
+{
+	depth = mClamp (depth, 1, MaxTextureRingDepth);
+	if (depth == mTextureRingDepth)
+	{
+		return;
+	}
+
+	mTextureRingDepth = depth;
+	if (!mResolution.isZero ())
+	{
+		createTextures ();
+	}
+}
+
 void AwContext::setCursorBitmapPath (const String &path)
 {
 	if (path.isEmpty ())
@@ -539,6 +935,13 @@ void AwContext::setCursorBitmapPath (const String &path)
 	Resource <GBitmap> bitmap = GBitmap::load (path);
 	if (bitmap)
 	{
+		// The cursor job might be compositing the old cursor.
+		if (mCursorJob)
+		{
+			mCursorJob->wait ();
+		}
+		mCursorTexture = nullptr;
+
 		mCursorBitmap = bitmap;
 	}
 }
@@ -570,7 +973,7 @@ U8 AwContext::getAlphaAtPoint (const Point2I &pnt)
 		return 255;
 	}
 
-	return ((Awesomium::BitmapSurface *)(mView->surface ()))->GetAlphaAtPoint (pnt.x, pnt.y);
+	return getSurface ()->getAlphaAtPoint (pnt.x, pnt.y);
 }
 
 void AwContext::showCursor ()
@@ -578,6 +981,16 @@ void AwContext::showCursor ()
 	mShowCursor = true;
 }
 
+GFXTexHandle AwContext::getCursorTexture ()
+{
+	if (!mCursorTexture && mCursorBitmap)
+	{
+		mCursorTexture.set (mCursorBitmap, &GFXDefaultGUIProfile, false, "AwContext cursor");
+	}
+
+	return mCursorTexture;
+}
+
 void AwContext::setSessionPath (const String &sessionPath)
 {
 	mSessionPath = sessionPath;
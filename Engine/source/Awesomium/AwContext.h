@@ -26,9 +26,37 @@
 #include <Awesomium/STLHelpers.h>
 
 #include "AwManager.h"
+#include "AwDirtyRegion.h"
+#include "AwJob.h"
+#include "AwPixelCopy.h"
 #include "console/console.h"
 #include "GFX/GFXTextureManager.h"
 
+class AwSurface;
+
+/*
+ *  AwCursorJob
+ *  -----------------------------------------------------------------------------------------------
+ *	Composites the cursor over a copy of the page pixels beneath it, on a worker thread. The job
+ *	owns its pixels, so Awesomium can keep painting into the surface meanwhile. AwContext uploads
+ *	the result over the page. Used internally by AwContext.
+ */
+class AwCursorJob : public AwJob
+{
+public:
+	U8 *mPixels;											// The page beneath the cursor, in the texture layout. The cursor is blended into it. Owned by the job.
+	RectI mArea;											// Where mPixels go on the page. Rows are mArea.extent.x * 4 bytes.
+	AwPixelCopy::CopyMode mCopyMode;						// How Awesomium's BGRA maps to the texture layout.
+	GBitmap *mCursorBitmap;
+	Point2I mCursorPos;
+
+	AwCursorJob (const U8 *page, U32 pagePitch, const RectI &area); // Copies the area of the page. Call on the main thread.
+	~AwCursorJob () { delete [] mPixels; }
+
+protected:
+	virtual void run ();									// Blends the cursor into mPixels. Supports 32-bit bitmaps only.
+};
+
 /*
  *  AwContext
  *  -----------------------------------------------------------------------------------------------
@@ -45,7 +73,20 @@ class AwContext : public Awesomium::WebViewListener::Load, public Awesomium::Web
 	String mCurrentURL;										// The current URL.
 
 	Resource <GBitmap> mCursorBitmap;						// The bitmap of the cursor. Has to contain alpha or it won't be used.
-	GFXTexHandle mTexture;									// The most recent texture fetched from Awesomium.
+	enum
+	{
+		MaxTextureRingDepth = 3
+	};
+
+	GFXTexHandle mTextures [MaxTextureRingDepth];			// Ring of textures. The next one is filled while the GPU may still be reading the others.
+	AwDirtyRegion mPendingRegions [MaxTextureRingDepth];	// The regions which are out of date in each texture of the ring.
+	U8 mTextureRingDepth;									// The number of textures in the ring. 1 disables buffering.
+	U8 mCurrentTexture;										// Index of the most recently completed texture.
+	Point2I mResolution;									// The resolution of the page. The textures can be larger if padding is allowed.
+	Point2I mPendingResolution;								// The resolution asked for by setResolution (), applied once it has stopped changing and the context isn't paused.
+	U32 mPendingResolutionTime;								// When the pending resolution was last changed.
+	bool mHasPendingResolution;
+	bool mAllowPaddedTextures;								// If set, the textures come from rounded pool buckets and can be larger than the resolution.
 	Point2I mCursorPos;										// The position of the cursor.
 	Point2I mCursorRenderPos;								// Interpolated position of the cursor.
 	U32 mFramerate;											// The estimated framerate.
@@ -53,9 +94,25 @@ class AwContext : public Awesomium::WebViewListener::Load, public Awesomium::Web
 	bool mShowCursor;										// Should we show the cursor bitmap?
 	bool mIsJavaScriptReady;								// When JavaScript has been initialized, this will be set to true.
 	bool mRenderedCursorLastFrame;							// If we rendered the cursor the last frame. Is used to force a redraw if the cursor was enabled but no new texture data was generated.
-
-	void blitCursorToTexture (GFXLockedRect *rect);			// Blits the cursor to the texture. Supports 32-bit bitmaps only.
-	void copyToTexture ();									// Reads the Awesomium surface and copies it to our texture.
+	bool mIsCursorOverlay;									// If set, the cursor is never composited into the texture. The owner draws it on top using getCursorTexture () instead.
+	GFXTexHandle mCursorTexture;							// Texture made from the cursor bitmap, created when it's first asked for.
+	F32 mDirtyAreaRatio;									// The fraction of the texture which was uploaded by the most recent copy.
+	bool mTexturesEnabled;									// If cleared, the ring is released and only the surface is kept up to date.
+	U32 mFrameNumber;										// Incremented every time an update finishes.
+
+	bool mIsUpdating;										// Set between beginUpdate () and finishUpdate ().
+	AwDirtyRegion mUpdateRegion;							// The regions collected by beginUpdate (), uploaded by finishUpdate ().
+	ThreadSafeRef <AwCursorJob> mCursorJob;					// The cursor compositing which is in flight, if any.
+	ThreadSafeRef <AwCursorJob> mCursorPatch;				// The most recently composited cursor. Uploaded over the page wherever that's out of date. Null if the cursor isn't composited.
+
+	AwSurface *getSurface ();								// Returns the surface of the view, or nullptr if there's none.
+	RectI getCursorRect (const Point2I &pos);				// Returns the area covered by the cursor bitmap when drawn at pos.
+	void copyToTexture ();									// Copies the out of date regions of the surface and the cursor to the next texture in the ring.
+	void cancelUpdate ();									// Waits for the cursor job and drops the update in flight. Its regions stay out of date in the surface.
+	void createTextures ();									// (Re)creates the textures of the ring, and marks them and the surface as fully out of date.
+	void createRing ();										// (Re)creates the textures of the ring only, and marks them as fully out of date.
+	void releaseRing ();									// Hands the textures of the ring back to the pool.
+	void applyResolution (const Point2I &resolution);		// Resizes the view and the textures right away.
 	void initView ();										// Initializes the Awesomium view.
 
 	struct JavaScriptObject
@@ -68,6 +125,7 @@ class AwContext : public Awesomium::WebViewListener::Load, public Awesomium::Web
 	Map <String, JavaScriptObject *> mJavaScriptObjectsByName; // Lookup table used to fetch JavaScriptObjects by their names. Used to bind Torque methods to JavaScript methods.
 
 	void onTorqueScript (const Vector <String> &args);		// Called when a TorqueScript method has been called from JavaScript.
+	void onSaveState (const Vector <String> &args);			// Called when the page posts back the state asked for by requestState ().
 	void clearJavaScriptBinds ();							// Clears all JavaScript binds used by the bridge.
 
 	Awesomium::JSValue OnMethodCallWithReturnValue (Awesomium::WebView *view, unsigned int id, const Awesomium::WebString &name, const Awesomium::JSArray &args) { return Awesomium::JSValue (); }
@@ -82,6 +140,10 @@ class AwContext : public Awesomium::WebViewListener::Load, public Awesomium::Web
 	
 	void OnDocumentReady (Awesomium::WebView *view, const Awesomium::WebURL &url);	// Called when the document is ready. We use this to initialize our JavaScript bridge.
 
+	Vector <String> mScriptsWhenReady;						// Scripts to run once the document is ready.
+	String mSavedState;										// The state posted back after the last requestState ().
+	bool mIsSavingState;									// Set from requestState () until the page has posted its state back.
+
 	void bindJavaScript (const String &objName, const String &funcName, const Delegate <void (const Vector <String> &)> &delegate);
 
 public:
@@ -110,27 +172,50 @@ public:
 	void undo ();
 	void redo ();											
 
-	void update ();											// Updates the texture if needed.
+	void beginUpdate ();									// Collects the changed regions and starts compositing the cursor on a worker thread, if an update is due.
+	void finishUpdate ();									// Waits for the cursor started by beginUpdate () and uploads the result.
+	void update () { beginUpdate (); finishUpdate (); }		// Updates the texture if needed.
 	bool isLoading ();										// If the document is ready this will return true.
 	void reload (bool ignoreCache = false);					// Reloads the view, optionally ignoring the cache.
 	void stop ();											// Stops loading which is in progress. Does nothing if the document is ready.			
 
 	void setFramerate (U8 framerate);						// Sets the framerate.
-	void setResolution (const Point2I &resolution);			// Sets the resolution and forces a redraw.
+	void setResolution (const Point2I &resolution, bool immediate = false); // Sets the resolution and forces a redraw. Unless immediate is set, changes are held back until the resolution has settled for $pref::Awesomium::ResizeDelay, so dragging a window edge doesn't reallocate on every step. A paused context holds them back until it resumes.
+	void setPaddedTextures (bool allow);					// Lets the textures be larger than the resolution, so they can be shared between sizes. Only for owners which draw the sub-rect given by getResolution ().
+	void setTextureRingDepth (U8 depth);					// Sets how many textures are cycled trough (1-3). More textures avoid stalls when the GPU still reads the previous frame, at the cost of memory.
 	void setSessionPath (const String &sessionPath);		// Sets the session path.
 	void setTransparent (bool isTransparent);				// Tells the context that the texture contains opacity information. This consumes additional amounts of memory (~15-25% of the texture's size)
 	void setCursorBitmapPath (const String &path);			// Sets the bitmap of the cursor.
 
 	void execJavaScript (const String &script);
+	void execJavaScriptWhenReady (const String &script);	// Executes the script once the document is ready, or right away if it already is.
+	void requestState (const String &script);				// Runs the script without waiting for it. Its result is posted back as a string through the bridge, see isSavingState ().
+	bool isSavingState () { return mIsSavingState; }		// Returns true until the page has answered requestState (). Pages which throw never answer.
+	const String &getSavedState () { return mSavedState; }	// Returns the result of the last requestState (), once it has arrived.
+	static String quoteJavaScriptString (const String &text); // Returns the UTF-8 text as a double-quoted JavaScript string literal, with everything that can't appear in one escaped.
+	String getViewURL ();									// Returns the URL the view is showing, which differs from getCurrentURL () once the user has followed a link.
 
 	bool isTransparent ();									// Returns true if the texture contains opacity information.
 	U8 getAlphaAtPoint (const Point2I &pnt);				// Returns alpha at the given point.
-	Point2I getResolution () { return Point2I (mTexture.getWidth (), mTexture.getHeight ()); }
-	GFXTexHandle getTexture () { update (); return mTexture; } // Returns the texture after redrawing it.
+	Point2I getResolution () { return mResolution; }
+	F32 getDirtyAreaRatio () { return mDirtyAreaRatio; }	// Returns the fraction of the texture which was uploaded by the most recent copy.
+	GFXTexHandle getTexture () { update (); return mTextures [mCurrentTexture]; } // Returns the most recently completed texture after redrawing it.
+	GFXTexHandle getCurrentTexture () { return mTextures [mCurrentTexture]; } // Returns the most recently completed texture without redrawing it. Used when updates are scheduled by someone else.
+	bool isUpdateDue ();									// Returns true if beginUpdate () would snapshot a new frame.
+	bool isUpdateReady () { return mIsUpdating && (!mCursorJob || mCursorJob->isDone ()); } // Returns true if finishUpdate () can upload without waiting.
+	U32 getPendingUploadBytes ();							// Returns roughly how many bytes finishUpdate () would upload right now.
+	void setTexturesEnabled (bool enabled);					// Releases or recreates the textures. While disabled, updates only reach the surface, which is useful when the owner keeps its own copy of the pixels.
+	bool areTexturesEnabled () { return mTexturesEnabled; }
+	U32 getFrameNumber () { return mFrameNumber; }			// Changes every time new pixels arrive. Can be used to find out if a copy of the pixels is out of date.
+	bool copyToBitmap (GBitmap *bmp);						// Copies the most recent pixels, without the cursor, into a GFXFormatR8G8B8A8 bitmap of the same resolution, without touching the GPU.
 
 	void showCursor ();
 	void hideCursor () { mShowCursor = false; }
 	bool isShowingCursor () { return mShowCursor; }
+	void setCursorOverlay (bool isOverlay) { mIsCursorOverlay = isOverlay; } // Draw the cursor as an overlay instead of compositing it into the texture. Cursor movement then costs no uploads.
+	bool isCursorOverlay () { return mIsCursorOverlay; }
+	GFXTexHandle getCursorTexture ();						// Returns the cursor bitmap as a texture, for drawing it as an overlay.
+	Point2I getCursorPosition () { return mCursorPos; }		// Returns the position of the cursor, in pixels.
 
 	void pause ();											// Same as disable () but has additional performance savings used when you want to use the context soon again.
 	void resume ();											// Resumes from a paused state.
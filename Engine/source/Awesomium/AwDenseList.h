@@ -0,0 +1,82 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Core/Util/tVector.h"
+
+/*
+ *  AwDenseList
+ *  -----------------------------------------------------------------------------------------------
+ *	Unordered list of pointers with O(1) add and remove. Each item stores its own position in a
+ *	U32 mDenseIndex member (and has to befriend the list), so removal never has to search, and the
+ *	gap is filled by moving the last item into it. An item can be in one list at a time.
+ */
+template <class T>
+class AwDenseList
+{
+	Vector <T *> mItems;
+
+	void move (U32 from, U32 to)
+	{
+		mItems [to] = mItems [from];
+		mItems [to]->mDenseIndex = to;
+	}
+
+public:
+	enum
+	{
+		InvalidIndex = 0xFFFFFFFF							// The index of items which are not in a list.
+	};
+
+	U32 size () const { return mItems.size (); }
+	T *operator [] (U32 index) const { return mItems [index]; }
+	const Vector <T *> &getItems () const { return mItems; }
+	bool contains (const T *item) const { return item->mDenseIndex < mItems.size () && mItems [item->mDenseIndex] == item; }
+
+	void add (T *item)
+	{
+		if (contains (item))
+		{
+			return;
+		}
+
+		item->mDenseIndex = mItems.size ();
+		mItems.push_back (item);
+	}
+
+	void remove (T *item)
+	{
+		if (!contains (item))
+		{
+			return;
+		}
+
+		U32 index = item->mDenseIndex;
+		U32 last = mItems.size () - 1;
+		if (index != last)
+		{
+			move (last, index);
+		}
+
+		mItems.pop_back ();
+		item->mDenseIndex = InvalidIndex;
+	}
+};
\ No newline at end of file
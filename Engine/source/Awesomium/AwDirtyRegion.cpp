@@ -0,0 +1,111 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwDirtyRegion.h"
+
+RectI AwDirtyRegion::getUnion (const RectI &a, const RectI &b)
+{
+	S32 minX = getMin (a.point.x, b.point.x);
+	S32 minY = getMin (a.point.y, b.point.y);
+	S32 maxX = getMax (a.point.x + a.extent.x, b.point.x + b.extent.x);
+	S32 maxY = getMax (a.point.y + a.extent.y, b.point.y + b.extent.y);
+	return RectI (minX, minY, maxX - minX, maxY - minY);
+}
+
+bool AwDirtyRegion::touches (const RectI &a, const RectI &b)
+{
+	return a.point.x <= b.point.x + b.extent.x && b.point.x <= a.point.x + a.extent.x &&
+		a.point.y <= b.point.y + b.extent.y && b.point.y <= a.point.y + a.extent.y;
+}
+
+void AwDirtyRegion::add (const RectI &rect)
+{
+	if (rect.extent.x <= 0 || rect.extent.y <= 0)
+	{
+		return;
+	}
+
+	// Grow the rectangle until it no longer touches any of the existing ones. Merging can make it
+	// touch rectangles it didn't touch before, so we start over whenever something was merged.
+	RectI merged = rect;
+	for (S32 i = 0; i < mRects.size (); i++)
+	{
+		if (touches (merged, mRects [i]))
+		{
+			merged = getUnion (merged, mRects [i]);
+			mRects.erase_fast (i);
+			i = -1;
+		}
+	}
+
+	if (mRects.size () < MaxRects)
+	{
+		mRects.push_back (merged);
+		return;
+	}
+
+	// Too many rectangles. Fold the new one into the rectangle whose union grows the least.
+	U32 best = 0;
+	S32 bestGrowth = S32_MAX;
+	for (U32 i = 0; i < mRects.size (); i++)
+	{
+		RectI u = getUnion (merged, mRects [i]);
+		S32 growth = (u.extent.x * u.extent.y) - (mRects [i].extent.x * mRects [i].extent.y);
+		if (growth < bestGrowth)
+		{
+			bestGrowth = growth;
+			best = i;
+		}
+	}
+
+	merged = getUnion (merged, mRects [best]);
+	mRects.erase_fast (best);
+	add (merged);
+}
+
+void AwDirtyRegion::add (const AwDirtyRegion &region)
+{
+	for (U32 i = 0; i < region.mRects.size (); i++)
+	{
+		add (region.mRects [i]);
+	}
+}
+
+void AwDirtyRegion::clip (const Point2I &size)
+{
+	RectI bounds (0, 0, size.x, size.y);
+	for (S32 i = mRects.size () - 1; i >= 0; i--)
+	{
+		if (!mRects [i].intersect (bounds))
+		{
+			mRects.erase_fast (i);
+		}
+	}
+}
+
+U32 AwDirtyRegion::getArea () const
+{
+	U32 area = 0;
+	for (U32 i = 0; i < mRects.size (); i++)
+	{
+		area += mRects [i].extent.x * mRects [i].extent.y;
+	}
+	return area;
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Platform/Types.h"
+#include "Math/mRect.h"
+#include "Core/Util/tVector.h"
+
+/*
+ *  AwDirtyRegion
+ *  -----------------------------------------------------------------------------------------------
+ *	A small set of rectangles describing which parts of a surface have changed. Overlapping
+ *	rectangles are merged into their union, and the set never grows beyond MaxRects entries.
+ */
+class AwDirtyRegion
+{
+	enum
+	{
+		MaxRects = 16										// Beyond this, new rectangles are merged into the closest existing one.
+	};
+
+	Vector <RectI> mRects;									// Non-overlapping dirty rectangles.
+
+	static RectI getUnion (const RectI &a, const RectI &b);	// Returns the smallest rectangle containing both a and b.
+	static bool touches (const RectI &a, const RectI &b);	// Returns true if the rectangles overlap or share an edge.
+
+public:
+	void add (const RectI &rect);							// Adds a rectangle, merging it with the rectangles it touches.
+	void add (const AwDirtyRegion &region);					// Adds all rectangles of another region.
+	void clip (const Point2I &size);						// Clips all rectangles to (0, 0, size.x, size.y) and drops the empty ones.
+	void clear () { mRects.clear (); }
+	bool isEmpty () const { return mRects.empty (); }
+	U32 getArea () const;									// Returns the summed area of all rectangles.
+	const Vector <RectI> &getRects () const { return mRects; }
+};
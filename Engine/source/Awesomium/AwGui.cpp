@@ -31,10 +31,12 @@ AwGui::AwGui ()
 	mBringToFrontWhenClicked = false;
 
 	mFramerate = 0;
+	mTextureRingDepth = 1;
 	mIsTransparent = false;
 	mResolution.set (0, 0);
 	mEnableRightMouseButton = false;
 	mUnloadOnSleep = true;
+	mCursorOverlay = false;
 }
 
 void AwGui::initPersistFields ()
@@ -42,6 +44,7 @@ void AwGui::initPersistFields ()
 	addField ("StartURL",				TypeRealString,		Offset (mStartURL, AwGui),					"The URL which is loaded initially.");
 	addField ("SessionPath",			TypeRealString,		Offset (mSessionPath, AwGui),				"Path to a session file which will contain cookies, history, passwords etc. A blank path forces the control to use the default session.");
 	addField ("Framerate",				TypeS8,				Offset (mFramerate, AwGui),					"The desired amount of frames per second to render. 0 means unlimited.");
+	addField ("TextureRingDepth",		TypeS8,				Offset (mTextureRingDepth, AwGui),			"The number of textures cycled trough when uploading (1-3). More textures avoid GPU stalls at the cost of memory. Default: 1");
 	addField ("IsTransparent",			TypeBool,			Offset (mIsTransparent, AwGui),				"Whether this control supports transparency or not. Default: Disabled");
 	addField ("Resolution",				TypePoint2I,		Offset (mResolution, AwGui),				"Forced resolution. Defaults to (0, 0) which lets AwGui and AwShape decide. In that case AwGui will set the resolution to the size "
 		"of the Gui control and AwShape will set the size to 800 x 600.");
@@ -50,6 +53,7 @@ void AwGui::initPersistFields ()
 	addField ("AlphaCutoff",			TypeS8,				Offset (mAlphaCutoff, AwGui),				"If the amount of alpha is below this value, no mouse events will be processed for that pixel.");
 	addField ("ShowLoadingScreen",		TypeBool,			Offset (mShowLoadingScreen, AwGui),			"Shows the loading screen if true. Default: Disabled");
 	addField ("BringToFrontWhenClicked",TypeBool,			Offset (mBringToFrontWhenClicked, AwGui),	"If enabled will bring the control to the top of the GUI stack when clicked. Default: Disabled");
+	addField ("CursorOverlay",			TypeBool,			Offset (mCursorOverlay, AwGui),				"Draws the cursor bitmap on top of the page while the mouse is over the control. The cursor is never composited into the texture. Default: Disabled");
 	addField ("EnableRightMouseButton",	TypeBool,			Offset (mEnableRightMouseButton, AwGui),	"Enables right-mouse clicks. If you're using Flash, this might not be desired as it can bring up its context menu. Default: Disabled");
 	Parent::initPersistFields ();
 }
@@ -80,9 +84,12 @@ bool AwGui::onWake ()
 
 	mContext = new AwContext;
 	mContext->setFramerate (mFramerate);
+	mContext->setTextureRingDepth (mTextureRingDepth);
 	mContext->setSessionPath (mSessionPath);
 	mContext->setTransparent (mIsTransparent);
+	mContext->setPaddedTextures (true);
 	mContext->setResolution (hasForcedResolution () ? mResolution : getExtent ());
+	mContext->setCursorOverlay (mCursorOverlay);
 	mContext->loadURL (mStartURL);
 
 	if (mContext)
@@ -110,14 +117,25 @@ void AwGui::onSleep ()
 	}
 }
 
+void AwGui::onPreRender ()
+{
+	Parent::onPreRender ();
+	if (mContext)
+	{
+		mContext->beginUpdate ();
+	}
+}
+
 void AwGui::inspectPostApply ()
 {
 	Parent::inspectPostApply ();
 
 	mContext->setFramerate (mFramerate);
+	mContext->setTextureRingDepth (mTextureRingDepth);
 	mContext->setSessionPath (mSessionPath);
 	mContext->setTransparent (mIsTransparent);
 	mContext->setResolution (hasForcedResolution () ? mResolution : getExtent ());
+	mContext->setCursorOverlay (mCursorOverlay);
 	mContext->loadURL (mStartURL);
 }
 
@@ -146,7 +164,7 @@ void AwGui::onRender (Point2I offset, const RectI &updateRect)
 		{
 			Point2I pnt = globalToLocalCoord (getRoot ()->getCursorPos ());
 
-			if (hasForcedResolution ())
+			if (mContext->getResolution () != getExtent ())
 			{
 				pnt.x = F32 ((F32)pnt.x / (F32)getWidth ()) * (F32)mContext->getResolution ().x;
 				pnt.y = F32 ((F32)pnt.y / (F32)getHeight ()) * (F32)mContext->getResolution ().y;
@@ -159,21 +177,43 @@ void AwGui::onRender (Point2I offset, const RectI &updateRect)
 		mCanHit = true;
 	}
 
-	if (mContext->getTexture ())
+	GFXTexHandle texture = mContext->getTexture ();
+	if (texture)
 	{
 		GFX->getDrawUtil ()->clearBitmapModulation ();
 
+		// The texture comes from a pool bucket and can be larger than the page, so only draw the part the page covers.
+		RectI source (Point2I (0, 0), mContext->getResolution ());
+
 		// If there is a forced resolution set, we stretch the bitmap across the control.
 		if (hasForcedResolution ())
 		{
-			GFX->getDrawUtil ()->drawBitmapStretch (mContext->getTexture (), updateRect);
+			GFX->getDrawUtil ()->drawBitmapStretchSR (texture, updateRect, source);
+		}
+		else if (source.extent == getExtent ())
+		{
+			GFX->getDrawUtil ()->drawBitmapSR (texture, offset, source);
 		}
 		else
 		{
-			GFX->getDrawUtil ()->drawBitmap (mContext->getTexture (), offset);
+			// A resize is pending. Stretch the old page across the control until it has settled.
+			GFX->getDrawUtil ()->drawBitmapStretchSR (texture, RectI (offset, getExtent ()), source);
 		}
 	}
 
+	// The cursor is drawn on top of the page, so moving it doesn't cost an upload.
+	if (mCursorOverlay && cursorInControl () && mContext->getCursorTexture ())
+	{
+		Point2I pnt = mContext->getCursorPosition ();
+		if (mContext->getResolution () != getExtent ())
+		{
+			pnt.x = F32 ((F32)pnt.x / (F32)mContext->getResolution ().x) * (F32)getWidth ();
+			pnt.y = F32 ((F32)pnt.y / (F32)mContext->getResolution ().y) * (F32)getHeight ();
+		}
+		GFX->getDrawUtil ()->clearBitmapModulation ();
+		GFX->getDrawUtil ()->drawBitmap (mContext->getCursorTexture (), offset + pnt);
+	}
+
 	if (mShowLoadingScreen && mContext->isLoading ())
 	{
 		GFX->getDrawUtil ()->drawRectFill (updateRect, ColorI (96, 96, 96, 196));
@@ -213,7 +253,7 @@ void AwGui::onMouseMove (const GuiEvent &evt)
 	
 	Point2I pnt = globalToLocalCoord (evt.mousePoint);
 
-	if (hasForcedResolution ())
+	if (mContext->getResolution () != getExtent ())
 	{
 		pnt.x = F32 ((F32)pnt.x / (F32)getWidth ()) * (F32)mContext->getResolution ().x;
 		pnt.y = F32 ((F32)pnt.y / (F32)getHeight ()) * (F32)mContext->getResolution ().y;
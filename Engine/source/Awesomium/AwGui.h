@@ -50,7 +50,9 @@ class AwGui : public GuiControl
 	bool mUnloadOnSleep;											// Unloads all resources if the AwGui goes asleep. This can be used to keep the memory footprint down. Defaults to enabled.
 	bool mIsTransparent;											// Whether this control supports transparency or not. Defaults to disabled.
 	U8 mFramerate;													// The desired amount of frames per second to render. 0 means unlimited.
+	U8 mTextureRingDepth;											// The number of textures cycled trough when uploading (1-3). More textures avoid GPU stalls at the cost of memory. Defaults to 1.
 	bool mEnableRightMouseButton;									// Enables right-mouse clicks. If you're using Flash, this might not be desired as it can bring its context menu. Defaults to disabled.
+	bool mCursorOverlay;											// Draws the cursor bitmap on top of the page while the mouse is over the control. The cursor is never composited into the texture. Defaults to disabled.
 
 	bool onAdd ();
 	void onRemove ();
@@ -75,6 +77,7 @@ class AwGui : public GuiControl
 
 	bool onWake ();
 	void onSleep ();
+	void onPreRender ();											// Collects the next frame ahead of rendering, so its cursor is composited on a worker meanwhile.
 	void inspectPostApply ();
 	bool resize (const Point2I &newPosition, const Point2I &newExtent);	// Redraws the context and resizes the control.
 
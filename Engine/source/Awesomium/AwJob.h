@@ -0,0 +1,68 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "platform/threads/threadPool.h"
+#include "platform/threads/semaphore.h"
+
+/*
+ *  AwJob
+ *  -----------------------------------------------------------------------------------------------
+ *	Work item for Torque's global thread pool which can be waited on like a fence. Used to move
+ *	pixel work off the main thread. Derived classes implement run ().
+ */
+class AwJob : public ThreadPool::WorkItem
+{
+	Semaphore mDone;										// Released once run () has returned. Kept released afterwards.
+
+protected:
+	virtual void run () = 0;
+
+	virtual void execute ()
+	{
+		run ();
+		mDone.release ();
+	}
+
+	virtual void onCancelled ()
+	{
+		mDone.release ();
+	}
+
+public:
+	AwJob () : mDone (0, 1) {}
+
+	void queue () { ThreadPool::GLOBAL ().queueWorkItem (this); } // Hands the job to the global thread pool.
+	void wait () { mDone.acquire (); mDone.release (); }	// Blocks until the job has finished. Can be called any number of times.
+
+	bool isDone ()											// Returns true if the job has finished, without blocking.
+	{
+		if (!mDone.acquire (false))
+		{
+			return false;
+		}
+
+		mDone.release ();
+		return true;
+	}
+};
+
+typedef ThreadSafeRef <AwJob> AwJobRef;
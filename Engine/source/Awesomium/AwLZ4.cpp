@@ -0,0 +1,233 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwLZ4.h"
+#include "platform/platform.h"
+
+enum
+{
+	MinMatch = 4,											// Matches are at least this long, so the token stores the length minus this.
+	LastLiterals = 5,										// The format requires the last bytes of a block to be literals.
+	MatchFindLimit = 12,									// No match may start within this many bytes of the end.
+	MaxOffset = 65535,
+	HashLog = 16
+};
+
+static inline U32 read32 (const U8 *ptr)
+{
+	U32 value;
+	dMemcpy (&value, ptr, 4);
+	return value;
+}
+
+static inline U32 hashSequence (U32 sequence)
+{
+	return (sequence * 2654435761U) >> (32 - HashLog);
+}
+
+static inline U8 *writeLength (U8 *op, U32 length)
+{
+	// Lengths which don't fit in the token continue in bytes of 255, ended by a smaller byte.
+	for (; length >= 255; length -= 255)
+	{
+		*op++ = 255;
+	}
+
+	*op++ = (U8)length;
+	return op;
+}
+
+static inline bool readLength (const U8 *&ip, const U8 *ipEnd, U32 &length)
+{
+	U8 byte;
+	do
+	{
+		if (ip >= ipEnd)
+		{
+			return false;
+		}
+
+		byte = *ip++;
+		length += byte;
+	}
+	while (byte == 255);
+
+	return true;
+}
+
+U32 AwLZ4::compress (const U8 *src, U32 srcSize, U8 *dst, U32 dstCapacity)
+{
+	if (dstCapacity < getMaxCompressedSize (srcSize))
+	{
+		return 0;
+	}
+
+	const U8 *ip = src;
+	const U8 *anchor = src;
+	const U8 *end = src + srcSize;
+	U8 *op = dst;
+
+	if (srcSize > MatchFindLimit)
+	{
+		// Positions of the last sequence seen for each hash.
+		U32 *table = new U32 [1 << HashLog];
+		dMemset (table, 0, sizeof (U32) * (1 << HashLog));
+
+		const U8 *matchLimit = end - LastLiterals;
+		const U8 *ipLimit = end - MatchFindLimit;
+		while (ip < ipLimit)
+		{
+			U32 sequence = read32 (ip);
+			U32 hash = hashSequence (sequence);
+			const U8 *candidate = src + table [hash];
+			table [hash] = (U32)(ip - src);
+
+			if (candidate >= ip || ip - candidate > MaxOffset || read32 (candidate) != sequence)
+			{
+				ip++;
+				continue;
+			}
+
+			const U8 *matchEnd = ip + MinMatch;
+			const U8 *candidateEnd = candidate + MinMatch;
+			while (matchEnd < matchLimit && *matchEnd == *candidateEnd)
+			{
+				matchEnd++;
+				candidateEnd++;
+			}
+
+			U32 literalLength = (U32)(ip - anchor);
+			U32 matchLength = (U32)(matchEnd - ip) - MinMatch;
+			U32 offset = (U32)(ip - candidate);
+
+			U8 *token = op++;
+			*token = (U8)(getMin (literalLength, 15U) << 4);
+			if (literalLength >= 15)
+			{
+				op = writeLength (op, literalLength - 15);
+			}
+
+			dMemcpy (op, anchor, literalLength);
+			op += literalLength;
+
+			*op++ = (U8)(offset & 0xFF);
+			*op++ = (U8)(offset >> 8);
+
+			*token |= (U8)getMin (matchLength, 15U);
+			if (matchLength >= 15)
+			{
+				op = writeLength (op, matchLength - 15);
+			}
+
+			ip = matchEnd;
+			anchor = ip;
+		}
+
+		delete [] table;
+	}
+
+	// The rest goes out as a final sequence of literals only.
+	U32 literalLength = (U32)(end - anchor);
+	*op++ = (U8)(getMin (literalLength, 15U) << 4);
+	if (literalLength >= 15)
+	{
+		op = writeLength (op, literalLength - 15);
+	}
+
+	dMemcpy (op, anchor, literalLength);
+	op += literalLength;
+
+	return (U32)(op - dst);
+}
+
+bool AwLZ4::decompress (const U8 *src, U32 srcSize, U8 *dst, U32 dstSize)
+{
+	const U8 *ip = src;
+	const U8 *ipEnd = src + srcSize;
+	U8 *op = dst;
+	U8 *opEnd = dst + dstSize;
+
+	while (ip < ipEnd)
+	{
+		U8 token = *ip++;
+
+		U32 literalLength = token >> 4;
+		if (literalLength == 15 && !readLength (ip, ipEnd, literalLength))
+		{
+			return false;
+		}
+
+		if (literalLength > (U32)(ipEnd - ip) || literalLength > (U32)(opEnd - op))
+		{
+			return false;
+		}
+
+		dMemcpy (op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+
+		// The last sequence has no match.
+		if (ip == ipEnd)
+		{
+			break;
+		}
+
+		if (ipEnd - ip < 2)
+		{
+			return false;
+		}
+
+		U32 offset = ip [0] | (ip [1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (U32)(op - dst))
+		{
+			return false;
+		}
+
+		U32 matchLength = token & 15;
+		if (matchLength == 15 && !readLength (ip, ipEnd, matchLength))
+		{
+			return false;
+		}
+
+		matchLength += MinMatch;
+		if (matchLength > (U32)(opEnd - op))
+		{
+			return false;
+		}
+
+		// Matches may overlap the bytes they produce, which repeats the pattern. Only copy in bulk when they don't.
+		const U8 *match = op - offset;
+		if (offset >= matchLength)
+		{
+			dMemcpy (op, match, matchLength);
+			op += matchLength;
+		}
+		else
+		{
+			for (U32 i = 0; i < matchLength; i++)
+			{
+				*op++ = *match++;
+			}
+		}
+	}
+
+	return op == opEnd;
+}
\ No newline at end of file
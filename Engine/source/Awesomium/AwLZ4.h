@@ -0,0 +1,38 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Platform/Types.h"
+
+/*
+ *  AwLZ4
+ *  -----------------------------------------------------------------------------------------------
+ *	Compressor and decompressor for the LZ4 block format. The compressor is a plain greedy one, as
+ *	it only runs on workers when a cache file is written. The decompressor checks every length
+ *	against both buffers, so a damaged file can't make it read or write out of bounds.
+ */
+class AwLZ4
+{
+public:
+	static U32 getMaxCompressedSize (U32 size) { return size + (size / 255) + 16; } // The largest size compress () can produce for the input size.
+	static U32 compress (const U8 *src, U32 srcSize, U8 *dst, U32 dstCapacity); // Returns the compressed size, or 0 if dst is smaller than getMaxCompressedSize ().
+	static bool decompress (const U8 *src, U32 srcSize, U8 *dst, U32 dstSize); // Returns true if the block decompressed to exactly dstSize bytes.
+};
\ No newline at end of file
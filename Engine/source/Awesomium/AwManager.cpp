@@ -31,6 +31,8 @@
 #include "Materials/MaterialManager.h"
 #include "T3D/GameBase/GameConnection.h"
 #include "gui/3d/guiTSControl.h"
+#include "scene/sceneRenderState.h"
+#include "GFX/GFXCardProfile.h"
 #include "Core/Stream/FileStream.h"
 
 #include "AwManager.h"
@@ -39,6 +41,14 @@
 #include "AwShape.h"
 #include "AwTextureCursor.h"
 #include "AwDataSource.h"
+#include "AwSurface.h"
+#include "AwPixelCopy.h"
+#include "AwTexturePool.h"
+#include "AwBitmapCache.h"
+#include "AwPrerenderer.h"
+#include "AwCacheLoader.h"
+
+#include <chrono>
 
 // Awesomium Headers
 #include <Awesomium/WebCore.h>
@@ -46,20 +56,38 @@
 #include <Awesomium/STLHelpers.h>
 
 AwDataSource *AwManager::sDataSource										= nullptr;
+AwSurfaceFactory *AwManager::sSurfaceFactory								= nullptr;
 U32	AwManager::sNumFrames													= 0;
+U32 AwManager::sFrameNumber													= 0;
+U32 AwManager::sResumeHysteresis											= 0;
+U32 AwManager::sHibernateTime												= 0;
 U32	AwManager::sFramerate													= 60;
 U32	AwManager::sNextUpdateTime												= 0;
 AwTextureCursor *AwManager::sCursor											= nullptr;
 F32	AwManager::sRayLengthScale												= 0.0f;
 F32	AwManager::sImageDropSpeed												= 0.0f;
 F32	AwManager::sLoadBalancingDistance										= 0.0f;
-U32 AwManager::sCurrentTargetIndex											= 0;
-U32 AwManager::sCurrentShapeIndex											= 0;
-U32 AwManager::sMaxIterationsPerFrame										= 64;
+Vector <AwTextureTarget *> AwManager::sUpdateQueue;
+F32 AwManager::sFrameBudget													= 0.0f;
+U32 AwManager::sUploadBudget												= 0;
+U32 AwManager::sUploadedBytes												= 0;
+U32 AwManager::sLoadBalancingMode											= AwManager::LoadBalanceDistance;
+F32 AwManager::sFullRateCoverage											= 0.0f;
+F32 AwManager::sViewportArea												= 0.0f;
+F32 AwManager::sShapeQueryRadius											= 0.0f;
+F32 AwManager::sResolutionLODDistance										= 0.0f;
+F32 AwManager::sResolutionLODHysteresis										= 0.0f;
+U32 AwManager::sResizeDelay													= 0;
+U32 AwManager::sBitmapCacheFormat											= 0;
+bool AwManager::sHasTextureFormat											= false;
+GFXFormat AwManager::sTextureFormat											= GFXFormatR8G8B8A8;
+AwPixelCopy::CopyMode AwManager::sTextureCopyMode							= AwPixelCopy::Copy;
 Map <BaseMatInstance *, AwTextureTarget *> AwManager::sTargetsByMaterial;
 Map <String, AwTextureTarget *> AwManager::sTextureTargetsByName;
-Vector <AwTextureTarget *> AwManager::sTargets;
-Vector <AwShape *> AwManager::sShapes;
+AwDenseList <AwTextureTarget> AwManager::sTargets;
+AwDenseList <AwShape> AwManager::sShapes;
+AwShapeGrid AwManager::sShapeGrid;
+Vector <AwShape *> AwManager::sShapeQueryResult;
 Map <String, Awesomium::WebSession *> AwManager::sSessions;
 Map <U8, int> AwManager::sKeyCodes;
 
@@ -99,8 +127,17 @@ void AwManager::init ()
 #endif
 	Awesomium::WebCore::Initialize (config);
 
+	sSurfaceFactory = new AwSurfaceFactory;
+	Awesomium::WebCore::instance ()->set_surface_factory (sSurfaceFactory);
+
+	AwPixelCopy::init ();
 	setupInput ();
 	readConsoleVariables ();
+	sShapeGrid.setCellSize (Con::getFloatVariable ("$pref::Awesomium::GridCellSize", 16.0f));
+
+	char cacheDirectory [1024];
+	Con::expandScriptFilename (cacheDirectory, sizeof (cacheDirectory), Con::getVariable ("$pref::Awesomium::BitmapCacheDirectory", "./awesomiumCache"));
+	AwBitmapCache::init (cacheDirectory);
 
 	SceneManager::getPreRenderSignal ().notify (onPreRender);
 	GFXDevice::getDeviceEventSignal ().notify (onDeviceEvent);
@@ -240,19 +277,37 @@ void AwManager::readConsoleVariables ()
 	sRayLengthScale	= Con::getFloatVariable ("$pref::Awesomium::RayLengthScale", 2.0f);
 	sImageDropSpeed	= Con::getFloatVariable ("$pref::Awesomium::ImageDropSpeed", 2.0f);
 	sLoadBalancingDistance = Con::getFloatVariable ("$pref::Awesomium::LoadBalancingDistance", 50.0f);
-	sMaxIterationsPerFrame = Con::getIntVariable ("$pref::Awesomium::MaxIterationsPerFrame", 64);
+	sFrameBudget = Con::getFloatVariable ("$pref::Awesomium::FrameBudgetMs", 2.0f);
+	sUploadBudget = Con::getIntVariable ("$pref::Awesomium::UploadBudgetKB", 4096) * 1024;
+	sResumeHysteresis = Con::getIntVariable ("$pref::Awesomium::ResumeHysteresis", 100);
+	sHibernateTime = Con::getIntVariable ("$pref::Awesomium::HibernateTime", 0);
+	sLoadBalancingMode = Con::getIntVariable ("$pref::Awesomium::LoadBalancingMode", LoadBalanceDistance);
+	sFullRateCoverage = getMax (Con::getFloatVariable ("$pref::Awesomium::FullRateCoverage", 0.25f), 0.001f);
+	sResolutionLODDistance = Con::getFloatVariable ("$pref::Awesomium::ResolutionLODDistance", 25.0f);
+	sResolutionLODHysteresis = mClampF (Con::getFloatVariable ("$pref::Awesomium::ResolutionLODHysteresis", 0.15f), 0.0f, 0.5f);
+	sResizeDelay = Con::getIntVariable ("$pref::Awesomium::ResizeDelay", 150);
+	sBitmapCacheFormat = getMin ((U32)Con::getIntVariable ("$pref::Awesomium::BitmapCacheFormat", AwBitmapCache::FormatLZ4), (U32)AwBitmapCache::FormatLZ4);
+	AwBitmapCache::setQuota ((U64)Con::getIntVariable ("$pref::Awesomium::BitmapCacheQuotaMB", 256) * 1024 * 1024);
+
+	// Far enough to cover load balancing and every resolution tier, including the hysteresis.
+	sShapeQueryRadius = getMax (sLoadBalancingDistance, sResolutionLODDistance * 2.0f * (1.0f + sResolutionLODHysteresis));
+	AwTexturePool::sMaxFreeBytes = Con::getIntVariable ("$pref::Awesomium::TexturePoolSize", 32) * 1024 * 1024;
+	AwTexturePool::sTimeout = Con::getIntVariable ("$pref::Awesomium::TexturePoolTimeout", 5000);
 }
 
 void AwManager::onPreRender (SceneManager *sceneManager, const SceneRenderState *state)
 {
 	SceneObject *controlObject = GameConnection::getConnectionToServer () ? GameConnection::getConnectionToServer ()->getControlObject () : nullptr;
 
-	if (!controlObject || sceneManager != controlObject->getSceneManager ())
+	// Reflections and shadows render the scene as well, but only the main view counts.
+	if (!controlObject || sceneManager != controlObject->getSceneManager () || !state->isDiffusePass ())
 	{
 		return;
 	}
 
 	sNumFrames++;
+	sFrameNumber++;
+	sViewportArea = getMax ((F32)(state->getViewport ().extent.x * state->getViewport ().extent.y), 1.0f);
 
 	// Every second..
 	U32 time = Platform::getRealMilliseconds ();
@@ -268,33 +323,115 @@ void AwManager::onPreRender (SceneManager *sceneManager, const SceneRenderState
 
 	if (sFramerate > 0)
 	{
-		for (S32 i = 0; i + sCurrentTargetIndex < sTargets.size () && i < sMaxIterationsPerFrame; i++)
+		scheduleTargets ();
+
+		// Only the shapes near the camera report their distance. Targets which get no report are treated as far away.
+		sShapeQueryResult.clear ();
+		sShapeGrid.findInRadius (controlObject->getRenderPosition (), sShapeQueryRadius, sShapeQueryResult);
+		for (U32 i = 0; i < sShapeQueryResult.size (); i++)
 		{
-			sTargets [sCurrentTargetIndex + i]->update (sFramerate);
+			AwShape *shape = sShapeQueryResult [i];
+
+			// The distance is used to load-balance and decrease the framerate and resolution of the targets. Culled shapes count as well, so targets
+			// don't drop in quality just by looking away. The coverage is reported by the shapes themselves when they survive culling, at any distance.
+			if (shape->getTextureTarget () && shape->getTextureTarget () != AwTextureTarget::sMouseInputTarget)
+			{
+				shape->getTextureTarget ()->reportDistance ((shape->getRenderPosition () - controlObject->getRenderPosition ()).len ());
+			}
 		}
 
-		sCurrentTargetIndex += sMaxIterationsPerFrame;
-		if (sCurrentTargetIndex + 1 >= sTargets.size ())
+		for (U32 i = 0; i < sTargets.size (); i++)
 		{
-			sCurrentTargetIndex = 0;
+			sTargets [i]->latchMetrics ();
 		}
+	}
+}
+
+F32 AwManager::getProjectedArea (SceneObject *object, const SceneRenderState *state)
+{
+	// Approximate the object with the sphere around its world box. Its projected radius shrinks linearly with the distance.
+	const Box3F &box = object->getWorldBox ();
+	F32 radius = box.len () * 0.5f;
+	F32 distance = (box.getCenter () - state->getCameraPosition ()).len ();
+	if (distance <= radius)
+	{
+		return sViewportArea;
+	}
+
+	F32 projectedRadius = (radius / distance) * state->getWorldToScreenScale ().y;
+	return getMin (M_PI_F * projectedRadius * projectedRadius, sViewportArea);
+}
+
+S32 QSORT_CALLBACK AwManager::comparePriority (AwTextureTarget * const *a, AwTextureTarget * const *b)
+{
+	if ((*a)->getPriority () < (*b)->getPriority ())
+	{
+		return 1;
+	}
+	else if ((*a)->getPriority () > (*b)->getPriority ())
+	{
+		return -1;
+	}
 
-		for (S32 i = 0; i + sCurrentShapeIndex < sShapes.size () && i < sMaxIterationsPerFrame; i++)
+	return 0;
+}
+
+void AwManager::scheduleTargets ()
+{
+	PROFILE_SCOPE (AwManager_scheduleTargets);
+
+	// The bookkeeping is cheap, so every target gets it every frame.
+	sUpdateQueue.clear ();
+	for (U32 i = 0; i < sTargets.size (); i++)
+	{
+		AwTextureTarget *target = sTargets [i];
+		target->update (sFramerate);
+		if (target->getPriority () > 0.0f)
 		{
-			AwShape *shape = sShapes [sCurrentShapeIndex + i];
+			sUpdateQueue.push_back (target);
+		}
+	}
 
-			// Calculate shape distance. This value is used to load-balance and decrease the framerate of the targets.
-			if (shape->getTextureTarget () && shape->getTextureTarget ()->getFramerate () == 0 && shape->getTextureTarget () != AwTextureTarget::sMouseInputTarget)
-			{
-				shape->getTextureTarget ()->setDistance ((shape->getRenderPosition () - controlObject->getRenderPosition ()).len ());
-			}
+	sUpdateQueue.sort (comparePriority);
+
+	// Spend the budget on the most important targets. Each target's cost is estimated from its previous updates,
+	// so we stop before going over budget rather than after. Uploads are limited by their size as well, so a
+	// lot of targets changing at once doesn't stall the GPU. Whatever doesn't fit is deferred to the next frame,
+	// where it will be more stale and therefore come earlier. The most important target always runs, so a target
+	// whose estimate exceeds the whole budget still gets updated and has its estimate measured again.
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+	F32 spent = 0.0f;
+	bool hasRun = false;
+	sUploadedBytes = 0;
+	for (U32 i = 0; i < sUpdateQueue.size (); i++)
+	{
+		AwTextureTarget *target = sUpdateQueue [i];
+		bool isExempt = !hasRun || target == AwTextureTarget::sMouseInputTarget;
+		U32 bytes = target->getPendingUploadBytes ();
+
+		// A cheaper target further down might still fit, so keep looking.
+		if (!isExempt && spent + target->mUpdateCost > sFrameBudget)
+		{
+			target->deferUpdate (bytes);
+			continue;
 		}
 
-		sCurrentShapeIndex += sMaxIterationsPerFrame;
-		if (sCurrentShapeIndex + 1 >= sShapes.size ())
+		if (!isExempt && sUploadedBytes > 0 && sUploadedBytes + bytes > sUploadBudget)
 		{
-			sCurrentShapeIndex = 0;
+			target->deferUpdate (bytes);
+			continue;
 		}
+
+		sUploadedBytes += bytes;
+		hasRun = true;
+
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now ();
+		target->runUpdate ();
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+
+		F32 cost = std::chrono::duration <F32, std::milli> (end - begin).count ();
+		target->mUpdateCost = target->mUpdateCost == 0.0f ? cost : (target->mUpdateCost * 0.75f) + (cost * 0.25f);
+		spent = std::chrono::duration <F32, std::milli> (end - start).count ();
 	}
 }
 
@@ -309,11 +446,66 @@ bool AwManager::onDeviceEvent (GFXDevice::GFXDeviceEventType evt)
 	if (evt == GFXDevice::deStartOfFrame)
 	{
 		Awesomium::WebCore::instance ()->Update ();
+		AwPrerenderer::process ();
+		AwCacheLoader::process ();
+		AwTexturePool::trim ();
+	}
+	else if (evt == GFXDevice::deDestroy)
+	{
+		// A new device may support other formats.
+		sHasTextureFormat = false;
+		AwTexturePool::clear ();
 	}
 
 	return true;
 }
 
+void AwManager::negotiateTextureFormat ()
+{
+	sHasTextureFormat = true;
+
+	// Direct3D stores GFXFormatR8G8B8A8 as BGRA in memory, which is exactly what Awesomium paints.
+	if (GFX->getAdapterType () != OpenGL)
+	{
+		sTextureFormat = GFXFormatR8G8B8A8;
+		sTextureCopyMode = AwPixelCopy::Copy;
+		return;
+	}
+
+	// OpenGL stores GFXFormatR8G8B8A8 as RGBA. Ask for a BGRA format instead, and let the driver deal with it.
+	bool autoGenMips = false;
+	if (GFX->getCardProfiler ()->checkFormat (GFXFormatB8G8R8A8, &GFXDynamicTextureProfile, autoGenMips))
+	{
+		sTextureFormat = GFXFormatB8G8R8A8;
+		sTextureCopyMode = AwPixelCopy::Copy;
+		return;
+	}
+
+	sTextureFormat = GFXFormatR8G8B8A8;
+	sTextureCopyMode = AwPixelCopy::SwapRB;
+	Con::warnf ("Awesomium: The device has no BGRA texture format, pixels will be swizzled on the CPU.");
+}
+
+GFXFormat AwManager::getTextureFormat ()
+{
+	if (!sHasTextureFormat)
+	{
+		negotiateTextureFormat ();
+	}
+
+	return sTextureFormat;
+}
+
+AwPixelCopy::CopyMode AwManager::getTextureCopyMode ()
+{
+	if (!sHasTextureFormat)
+	{
+		negotiateTextureFormat ();
+	}
+
+	return sTextureCopyMode;
+}
+
 AwTextureTarget *AwManager::findTextureTargetByMaterial (BaseMatInstance *mat)
 {
 	PROFILE_SCOPE (AwManager_findTextureTarget);
@@ -328,7 +520,8 @@ AwTextureTarget *AwManager::findTextureTargetByMaterial (BaseMatInstance *mat)
 
 void AwManager::addShape (AwShape *shape)
 {
-	sShapes.push_back (shape);
+	sShapes.add (shape);
+	sShapeGrid.insert (shape);
 
 	TSShapeInstance *shapeInstance = shape->getShapeInstance ();
 	TSMaterialList *list = shapeInstance->getMaterialList ();
@@ -356,7 +549,8 @@ void AwManager::addShape (AwShape *shape)
 
 void AwManager::removeShape (AwShape *shape)
 {
-	sShapes.remove (shape); // TODO: This operation is O(n) which might be a problem with huge amounts of shapes or if shapes are often removed.
+	sShapes.remove (shape);
+	sShapeGrid.remove (shape);
 	if (shape->mTextureTarget)
 	{
 		shape->mTextureTarget->mNumShapesBound--;
@@ -367,15 +561,71 @@ void AwManager::removeShape (AwShape *shape)
 	}
 }
 
+void AwManager::updateShape (AwShape *shape)
+{
+	sShapeGrid.update (shape);
+}
+
+AwShape *AwManager::pickShape (const Point3F &start, const Point3F &end)
+{
+	struct Hit
+	{
+		AwShape *shape;
+		F32 t;
+	};
+
+	sShapeQueryResult.clear ();
+	sShapeGrid.findAlongRay (start, end, sShapeQueryResult);
+
+	// The cells only tell which shapes might be hit, so test their boxes before the (much more expensive) surface test.
+	Vector <Hit> hits;
+	for (U32 i = 0; i < sShapeQueryResult.size (); i++)
+	{
+		Hit hit;
+		Point3F normal;
+		hit.shape = sShapeQueryResult [i];
+		if (hit.shape->getWorldBox ().isContained (start))
+		{
+			hit.t = 0.0f;
+			hits.push_back (hit);
+		}
+		else if (hit.shape->getWorldBox ().collideLine (start, end, &hit.t, &normal))
+		{
+			hits.push_back (hit);
+		}
+	}
+
+	while (!hits.empty ())
+	{
+		U32 nearest = 0;
+		for (U32 i = 1; i < hits.size (); i++)
+		{
+			if (hits [i].t < hits [nearest].t)
+			{
+				nearest = i;
+			}
+		}
+
+		if (hits [nearest].shape->processAwesomiumHit (start, end))
+		{
+			return hits [nearest].shape;
+		}
+
+		hits.erase_fast (nearest);
+	}
+
+	return nullptr;
+}
+
 void AwManager::addTextureTarget (AwTextureTarget *target)
 {
-	sTargets.push_back (target);
+	sTargets.add (target);
 	sTextureTargetsByName.insert ("#" + target->mTexTargetName, target);
 }
 
 void AwManager::removeTextureTarget (AwTextureTarget *target)
 {
-	sTargets.remove (target); // TODO: This operation is O(n) which might be a problem with huge amounts of targets or if targets are often removed.
+	sTargets.remove (target);
 	sTextureTargetsByName.erase ("#" + target->mTexTargetName);
 }
 
@@ -386,6 +636,9 @@ void AwManager::shutdown ()
 		return;
 	}
 
+	AwPrerenderer::cancel ();
+	AwCacheLoader::cancel ();
+
 	delete sDataSource;
 	sDataSource = nullptr;
 
@@ -397,6 +650,12 @@ void AwManager::shutdown ()
 	
 	Awesomium::WebCore::Shutdown ();
 
+	delete sSurfaceFactory;
+	sSurfaceFactory = nullptr;
+
+	AwTexturePool::clear ();
+	AwBitmapCache::shutdown ();
+
 	GFXDevice::getDeviceEventSignal ().remove (onDeviceEvent);
 }
 
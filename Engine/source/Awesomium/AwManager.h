@@ -23,6 +23,9 @@
 #include "Core/Util/TDictionary.h"
 #include "GFX/GFXDevice.h"
 #include "Core/Util/tVector.h"
+#include "AwPixelCopy.h"
+#include "AwDenseList.h"
+#include "AwShapeGrid.h"
 
 namespace Awesomium
 {
@@ -37,6 +40,7 @@ class BaseMatInstance;
 class SceneObject;
 class AwTextureCursor;
 class AwDataSource;
+class AwSurfaceFactory;
 
 /*
  *  AwManager
@@ -50,18 +54,23 @@ class AwManager
 	friend class AwContext;
 
 	static AwDataSource *AwManager::sDataSource;							// Used to fetch data from Torque's filesystem. Required for using compressed packages.
-	static Vector <AwShape *> sShapes;										// List of all currently instantiated AwShapes.
-	static Vector <AwTextureTarget *> sTargets;								// List of all currently instantiated AwTargets.
+	static AwSurfaceFactory *sSurfaceFactory;								// Creates the surfaces Awesomium paints into. Tracks dirty regions so only changed parts are uploaded.
+	static AwDenseList <AwShape> sShapes;									// List of all currently instantiated AwShapes.
+	static AwDenseList <AwTextureTarget> sTargets;							// List of all currently instantiated AwTargets.
+	static AwShapeGrid sShapeGrid;											// Spatial index over sShapes, used to find the shapes near the camera and under the cursor.
+	static Vector <AwShape *> sShapeQueryResult;							// Scratch list for sShapeGrid queries. Kept around to avoid allocating every frame.
 	static Map <String, AwTextureTarget *> sTextureTargetsByName;			// Lookup table used to fetch AwTargets by their name.
 	static Map <BaseMatInstance *, AwTextureTarget *> sTargetsByMaterial;	// Lookup table used to fetch AwTargets by their associated material instance.
 	static Map <String, Awesomium::WebSession *> sSessions;					// Lookup table used to fetch sessions by their paths.
 	static Map <U8, int> sKeyCodes;											// Lookup table used to translate keycodes between Awesomium and Torque.
 	
-	static U32 sCurrentTargetIndex;											// Index used to iterate trough lists in segments each frame instead of all at once which could result in too much time spent in one frame.							
-	static U32 sCurrentShapeIndex;											// Index used to iterate trough lists in segments each frame instead of all at once which could result in too much time spent in one frame.		
+	static Vector <AwTextureTarget *> sUpdateQueue;							// The targets which want an update this frame, most important first. Kept around to avoid allocating every frame.
 
 	static U32 sNextUpdateTime;												// The next time we want to do periodic updates.									
 	static U32 sNumFrames;													// The number of frames rendered so far the past second.
+	static U32 sFrameNumber;												// Incremented once per rendered frame. Used to find out what was visible the previous frame.
+	static U32 sResumeHysteresis;											// Milliseconds a paused target has to stay visible before it resumes.
+	static U32 sHibernateTime;												// Milliseconds a target has to stay invisible before its view is destroyed. 0 disables hibernation, the default.
 	static U32 sFramerate;													// Our estimated framerate, used in performance tuning of targets and shapes.												
 	
 	static AwTextureCursor *sCursor;
@@ -69,17 +78,35 @@ class AwManager
 	static F32 sRayLengthScale;												// Scales the distance of the ray used to pick the input target.
 	static F32 sImageDropSpeed;												// The speed at which the Players' ShapeImages are dropped when an AwShape receives focus. Set this to <= 0.0f to disable the feature.
 	static F32 sLoadBalancingDistance;										// The distance for Load Balancing. A higher value sacrifices performance for quality.
-	static U32 sMaxIterationsPerFrame;										// The maximum number of iterations done per frame.
+	static U32 sLoadBalancingMode;											// Whether targets are balanced by distance or by how much of the screen they cover. See LoadBalancingMode.
+	static F32 sFullRateCoverage;											// In coverage mode, the fraction of the screen a target has to cover to get the full framerate and resolution.
+	static F32 sViewportArea;												// The area of the viewport in pixels, as of the last frame.
+	static F32 sShapeQueryRadius;											// Shapes further away than this don't report their distance. Targets without a shape in range are treated as far away.
+	static F32 sFrameBudget;												// Milliseconds per frame spent on uploading and snapshotting targets. The focused and the most important target are always updated. AwGui contexts aren't budgeted.
+	static U32 sUploadBudget;												// Bytes per frame uploaded to textures. The focused target and the first upload of a frame are always let through.
+	static U32 sUploadedBytes;												// Bytes uploaded so far this frame.
+	static F32 sResolutionLODDistance;										// The distance at which targets drop to half resolution. At twice the distance they drop to a quarter. 0 disables resolution LOD.
+	static F32 sResolutionLODHysteresis;									// How far (as a fraction of the tier distance) a target has to move past a tier border before its resolution changes.
+	static U32 sResizeDelay;												// Milliseconds the resolution of a context has to stay unchanged before the view and textures are resized. Paused contexts wait until they resume.
+	static U32 sBitmapCacheFormat;											// The format new bitmap cache files are written in. See AwBitmapCache::Format.
+
+	static bool sHasTextureFormat;											// Set once the texture format has been negotiated with the device.
+	static GFXFormat sTextureFormat;										// The format of all Awesomium textures.
+	static AwPixelCopy::CopyMode sTextureCopyMode;							// How Awesomium's BGRA pixels have to be converted to match sTextureFormat.
 
 	static Awesomium::WebSession *getSessionFromPath (const String &path);
 
 	static void addShape (AwShape *shape);									// Adds the shape to the manager, goes trough the material and finds the texture targets. Requires that the targets have been added before this call.
 	static void removeShape (AwShape *shape);								// Removes the shape from the manager.
+	static void updateShape (AwShape *shape);								// Moves the shape in the spatial index. Call when it has moved or scaled.
 	static void addTextureTarget (AwTextureTarget *target);					// Adds the target to the manager.
 	static void removeTextureTarget (AwTextureTarget *target);				// Removes the target from the manager.
 	static AwTextureTarget *findTextureTargetByMaterial (BaseMatInstance *mat); // Finds the texture target by passing in its associated material instance.
 
 	static void readConsoleVariables ();	
+	static void scheduleTargets ();											// Updates the most important targets first, until the frame budget is used up.
+	static S32 QSORT_CALLBACK comparePriority (AwTextureTarget * const *a, AwTextureTarget * const *b);
+	static void negotiateTextureFormat ();									// Picks a texture format which stores pixels as BGRA, so no swizzling is needed. Falls back to RGBA with a CPU swizzle.
 	static void setupInput ();
 
 	static bool onDeviceEvent (GFXDevice::GFXDeviceEventType evt);
@@ -87,11 +114,33 @@ class AwManager
 	static void onPostRender (SceneManager *sceneManager, const SceneRenderState *state);
 	
 public:
+	enum LoadBalancingMode
+	{
+		LoadBalanceDistance,												// Quality drops with the distance to the nearest shape. The default.
+		LoadBalanceCoverage													// Quality follows the screen area covered by the shapes.
+	};
+
 	static F32 getRayLengthScale () { return sRayLengthScale; }				// Scales the distance of the ray used to pick the input target.
 	static F32 getImageDropSpeed () { return sImageDropSpeed; }				// The speed at which the Players' ShapeImages are dropped when an AwShape receives focus. Set this to 0.0f to disable the feature.
 	static F32 getLoadBalancingDistance () { return sLoadBalancingDistance; } // The distance for Load Balancing. A higher value sacrifices performance for quality.
+	static U32 getLoadBalancingMode () { return sLoadBalancingMode; }		// Whether targets are balanced by distance or by how much of the screen they cover. See LoadBalancingMode.
+	static F32 getFullRateCoverage () { return sFullRateCoverage; }			// In coverage mode, the fraction of the screen a target has to cover to get the full framerate and resolution.
+	static F32 getViewportArea () { return sViewportArea; }					// The area of the viewport in pixels, as of the last frame.
+	static F32 getResolutionLODDistance () { return sResolutionLODDistance; } // The distance at which targets drop to half resolution. 0 disables resolution LOD.
+	static F32 getResolutionLODHysteresis () { return sResolutionLODHysteresis; }
+	static F32 getShapeQueryRadius () { return sShapeQueryRadius; }			// Shapes further away than this don't report their distance.
+	static U32 getFrameNumber () { return sFrameNumber; }					// Incremented once per rendered frame, before culling.
+	static U32 getResumeHysteresis () { return sResumeHysteresis; }			// Milliseconds a paused target has to stay visible before it resumes.
+	static U32 getHibernateTime () { return sHibernateTime; }				// Milliseconds a target has to stay invisible before its view is destroyed. 0 disables hibernation.
+	static U32 getUploadedBytes () { return sUploadedBytes; }				// Bytes uploaded to target textures this frame.
+	static U32 getBitmapCacheFormat () { return sBitmapCacheFormat; }		// The format new bitmap cache files are written in. See AwBitmapCache::Format.
+	static U32 getResizeDelay () { return sResizeDelay; }					// Milliseconds the resolution of a context has to stay unchanged before the view and textures are resized. Paused contexts wait until they resume.
 	
-	static Vector <AwTextureTarget *> &getTargets () { return sTargets; }	// Returns all managed targets.
+	static F32 getProjectedArea (SceneObject *object, const SceneRenderState *state); // Returns roughly how many pixels the object covers on the screen.
+	static AwShape *pickShape (const Point3F &start, const Point3F &end);	// Returns the nearest AwShape along the segment whose surface was hit, with the hit already processed. Null if none.
+	static const Vector <AwTextureTarget *> &getTargets () { return sTargets.getItems (); } // Returns all managed targets, in no particular order.
+	static GFXFormat getTextureFormat ();									// Returns the format to create Awesomium textures with.
+	static AwPixelCopy::CopyMode getTextureCopyMode ();						// Returns how Awesomium's BGRA pixels have to be converted to the texture format.
 
 	static void init ();
 	static void shutdown ();	
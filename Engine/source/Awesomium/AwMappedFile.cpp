@@ -0,0 +1,122 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwMappedFile.h"
+#include "platform/platform.h"
+
+#ifdef TORQUE_OS_WIN
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+AwMappedFile::AwMappedFile ()
+{
+	mData = nullptr;
+	mSize = 0;
+#ifdef TORQUE_OS_WIN
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = nullptr;
+#endif
+}
+
+bool AwMappedFile::open (const String &path)
+{
+	close ();
+
+	char fullPath [2048];
+	Platform::makeFullPathName (path.c_str (), fullPath, sizeof (fullPath));
+
+#ifdef TORQUE_OS_WIN
+	mFile = CreateFileA (fullPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx (mFile, &size) || size.QuadPart == 0 || size.QuadPart > 0xFFFFFFFF)
+	{
+		close ();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA (mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	mData = mMapping ? (const U8 *)MapViewOfFile (mMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	mSize = (U32)size.QuadPart;
+#else
+	int fd = ::open (fullPath, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat (fd, &info) != 0 || info.st_size == 0 || (U64)info.st_size > 0xFFFFFFFF)
+	{
+		::close (fd);
+		return false;
+	}
+
+	// The mapping keeps the file alive, so the descriptor isn't needed anymore.
+	void *data = mmap (nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close (fd);
+	mData = data != MAP_FAILED ? (const U8 *)data : nullptr;
+	mSize = (U32)info.st_size;
+#endif
+
+	if (!mData)
+	{
+		close ();
+		return false;
+	}
+
+	return true;
+}
+
+void AwMappedFile::close ()
+{
+#ifdef TORQUE_OS_WIN
+	if (mData)
+	{
+		UnmapViewOfFile (mData);
+	}
+	if (mMapping)
+	{
+		CloseHandle (mMapping);
+	}
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle (mFile);
+	}
+	mMapping = nullptr;
+	mFile = INVALID_HANDLE_VALUE;
+#else
+	if (mData)
+	{
+		munmap ((void *)mData, mSize);
+	}
+#endif
+	mData = nullptr;
+	mSize = 0;
+}
\ No newline at end of file
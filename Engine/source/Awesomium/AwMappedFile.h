@@ -0,0 +1,54 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Platform/Types.h"
+#include "core/util/str.h"
+
+/*
+ *  AwMappedFile
+ *  -----------------------------------------------------------------------------------------------
+ *	Read-only memory mapping of a whole file. Unmapped when it's closed or goes out of scope, so
+ *	the data can be used straight from the page cache for as long as the owner keeps it open.
+ */
+class AwMappedFile
+{
+	const U8 *mData;
+	U32 mSize;
+#ifdef TORQUE_OS_WIN
+	void *mFile;											// The file HANDLE, kept out of this header so it doesn't pull in windows.h.
+	void *mMapping;											// The file mapping HANDLE.
+#endif
+
+	AwMappedFile (const AwMappedFile &);					// Not copyable, the mapping belongs to one owner.
+	AwMappedFile &operator = (const AwMappedFile &);
+
+public:
+	AwMappedFile ();
+	~AwMappedFile () { close (); }
+
+	const U8 *getData () const { return mData; }
+	U32 getSize () const { return mSize; }
+	bool isOpen () const { return mData != nullptr; }
+
+	bool open (const String &path);							// Maps the whole file. Fails for missing and empty files and files over 4 GB.
+	void close ();
+};
\ No newline at end of file
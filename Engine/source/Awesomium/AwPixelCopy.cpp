@@ -0,0 +1,150 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwPixelCopy.h"
+#include "platform/platform.h"
+
+#if defined (TORQUE_CPU_X86) || defined (TORQUE_CPU_X64)
+	#define AW_PIXELCOPY_SSE
+	#include <emmintrin.h>
+	#include <tmmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+	#define AW_PIXELCOPY_NEON
+	#include <arm_neon.h>
+#endif
+
+// GCC and Clang only emit SSSE3 instructions in functions which ask for them. MSVC always does.
+#if defined (AW_PIXELCOPY_SSE) && (defined (__GNUC__) || defined (__clang__))
+	#define AW_TARGET_SSSE3 __attribute__ ((target ("ssse3")))
+#else
+	#define AW_TARGET_SSSE3
+#endif
+
+AwPixelCopy::RowFunc AwPixelCopy::sRowFuncs [AwPixelCopy::NumCopyModes];
+const char *AwPixelCopy::sKernelName = "Scalar";
+
+static void copyRow (U8 *dst, const U8 *src, U32 numPixels)
+{
+	dMemcpy (dst, src, numPixels * 4);
+}
+
+static void swapRBRowScalar (U8 *dst, const U8 *src, U32 numPixels)
+{
+	for (U32 i = 0; i < numPixels; i++)
+	{
+		U32 pixel;
+		dMemcpy (&pixel, src + i * 4, 4);
+		pixel = (pixel & 0xFF00FF00) | ((pixel >> 16) & 0x000000FF) | ((pixel & 0x000000FF) << 16);
+		dMemcpy (dst + i * 4, &pixel, 4);
+	}
+}
+
+#ifdef AW_PIXELCOPY_SSE
+static void swapRBRowSSE2 (U8 *dst, const U8 *src, U32 numPixels)
+{
+	const __m128i maskAG = _mm_set1_epi32 (0xFF00FF00);
+	const __m128i maskRB = _mm_set1_epi32 (0x00FF00FF);
+
+	U32 i = 0;
+	for (; i + 4 <= numPixels; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128 ((const __m128i *)(src + i * 4));
+		__m128i rb = _mm_and_si128 (pixels, maskRB);
+		rb = _mm_or_si128 (_mm_slli_epi32 (rb, 16), _mm_srli_epi32 (rb, 16));
+		_mm_storeu_si128 ((__m128i *)(dst + i * 4), _mm_or_si128 (_mm_and_si128 (pixels, maskAG), rb));
+	}
+
+	swapRBRowScalar (dst + i * 4, src + i * 4, numPixels - i);
+}
+
+AW_TARGET_SSSE3 static void swapRBRowSSSE3 (U8 *dst, const U8 *src, U32 numPixels)
+{
+	const __m128i shuffle = _mm_setr_epi8 (2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+	// Two registers per iteration keeps both load ports busy.
+	U32 i = 0;
+	for (; i + 8 <= numPixels; i += 8)
+	{
+		__m128i a = _mm_loadu_si128 ((const __m128i *)(src + i * 4));
+		__m128i b = _mm_loadu_si128 ((const __m128i *)(src + i * 4 + 16));
+		_mm_storeu_si128 ((__m128i *)(dst + i * 4), _mm_shuffle_epi8 (a, shuffle));
+		_mm_storeu_si128 ((__m128i *)(dst + i * 4 + 16), _mm_shuffle_epi8 (b, shuffle));
+	}
+
+	swapRBRowScalar (dst + i * 4, src + i * 4, numPixels - i);
+}
+#endif
+
+#ifdef AW_PIXELCOPY_NEON
+static void swapRBRowNEON (U8 *dst, const U8 *src, U32 numPixels)
+{
+	U32 i = 0;
+	for (; i + 16 <= numPixels; i += 16)
+	{
+		uint8x16x4_t pixels = vld4q_u8 (src + i * 4);
+		uint8x16_t r = pixels.val [0];
+		pixels.val [0] = pixels.val [2];
+		pixels.val [2] = r;
+		vst4q_u8 (dst + i * 4, pixels);
+	}
+
+	swapRBRowScalar (dst + i * 4, src + i * 4, numPixels - i);
+}
+#endif
+
+AwPixelCopy::BlitFunc AwPixelCopy::getBlitFunc (GFXFormat dstFormat, CopyMode mode)
+{
+	switch (dstFormat)
+	{
+	case GFXFormatR8G8B8A8:
+		return mode == SwapRB ? &AwBlitter <SourceBGRA8, GFXFormatR8G8B8A8, SwapRB>::blit : &AwBlitter <SourceBGRA8, GFXFormatR8G8B8A8, Copy>::blit;
+	case GFXFormatR8G8B8X8:
+		return mode == SwapRB ? &AwBlitter <SourceBGRA8, GFXFormatR8G8B8X8, SwapRB>::blit : &AwBlitter <SourceBGRA8, GFXFormatR8G8B8X8, Copy>::blit;
+	case GFXFormatB8G8R8A8:
+		return mode == SwapRB ? &AwBlitter <SourceBGRA8, GFXFormatB8G8R8A8, SwapRB>::blit : &AwBlitter <SourceBGRA8, GFXFormatB8G8R8A8, Copy>::blit;
+	default:
+		return nullptr;
+	}
+}
+
+void AwPixelCopy::init ()
+{
+	// A straight copy is memory bound, the CRT memcpy is as fast as anything we could write.
+	sRowFuncs [Copy] = copyRow;
+	sRowFuncs [SwapRB] = swapRBRowScalar;
+	sKernelName = "Scalar";
+
+#if defined (AW_PIXELCOPY_SSE)
+	U32 properties = Platform::SystemInfo.processor.properties;
+	if (properties & CPU_PROP_SSE3xt)
+	{
+		sRowFuncs [SwapRB] = swapRBRowSSSE3;
+		sKernelName = "SSSE3";
+	}
+	else if (properties & CPU_PROP_SSE2)
+	{
+		sRowFuncs [SwapRB] = swapRBRowSSE2;
+		sKernelName = "SSE2";
+	}
+#elif defined (AW_PIXELCOPY_NEON)
+	sRowFuncs [SwapRB] = swapRBRowNEON;
+	sKernelName = "NEON";
+#endif
+}
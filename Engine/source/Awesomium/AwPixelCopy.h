@@ -0,0 +1,127 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Platform/Types.h"
+#include "GFX/gfxEnums.h"
+
+/*
+ *  AwPixelCopy
+ *  -----------------------------------------------------------------------------------------------
+ *	Row kernels used to move 32-bit pixels from Awesomium surfaces into textures. The best kernel
+ *	for the running CPU (SSE2, SSSE3, NEON or scalar) is picked once by init ().
+ */
+class AwPixelCopy
+{
+public:
+	enum CopyMode
+	{
+		Copy,												// Straight copy, the layouts match.
+		SwapRB,												// Swaps the first and third byte of every pixel (BGRA <-> RGBA).
+		NumCopyModes
+	};
+
+	enum SourceFormat
+	{
+		SourceBGRA8											// 32-bit BGRA, which is what Awesomium paints.
+	};
+
+	typedef void (*RowFunc) (U8 *dst, const U8 *src, U32 numPixels);
+	typedef void (*BlitFunc) (U8 *dst, U32 dstPitch, const U8 *src, U32 srcPitch, U32 width, U32 height);
+
+	static void init ();									// Detects the CPU features and picks the kernels. Called by AwManager::init ().
+	static RowFunc getRowFunc (CopyMode mode) { return sRowFuncs [mode]; }
+	static BlitFunc getBlitFunc (GFXFormat dstFormat, CopyMode mode); // Returns the blitter specialized for the format and mode, or nullptr if the format isn't supported.
+	static const char *getKernelName () { return sKernelName; } // Returns the name of the instruction set used by the SwapRB kernel.
+
+private:
+	static RowFunc sRowFuncs [NumCopyModes];
+	static const char *sKernelName;
+};
+
+
+/*
+ *  AwSourceTraits / AwTextureTraits
+ *  -----------------------------------------------------------------------------------------------
+ *	Compile-time description of the pixel layouts the blitters can read from and write to.
+ *	Only formats with a specialization can be used as blit targets.
+ */
+template <AwPixelCopy::SourceFormat Format> struct AwSourceTraits;
+
+template <> struct AwSourceTraits <AwPixelCopy::SourceBGRA8>
+{
+	enum { BytesPerPixel = 4 };
+};
+
+template <GFXFormat Format> struct AwTextureTraits;
+
+template <> struct AwTextureTraits <GFXFormatR8G8B8A8>
+{
+	enum { BytesPerPixel = 4 };
+};
+
+template <> struct AwTextureTraits <GFXFormatR8G8B8X8>
+{
+	enum { BytesPerPixel = 4 };
+};
+
+template <> struct AwTextureTraits <GFXFormatB8G8R8A8>
+{
+	enum { BytesPerPixel = 4 };
+};
+
+/*
+ *  AwBlitter
+ *  -----------------------------------------------------------------------------------------------
+ *	Copies a block of pixels between two buffers with their own pitches. When no swizzle is
+ *	needed and the pixel sizes match, rows are copied with memcpy, and if both buffers are
+ *	tightly packed the whole block is copied at once.
+ */
+template <AwPixelCopy::SourceFormat SrcFormat, GFXFormat DstFormat, AwPixelCopy::CopyMode Mode>
+struct AwBlitter
+{
+	static void blit (U8 *dst, U32 dstPitch, const U8 *src, U32 srcPitch, U32 width, U32 height)
+	{
+		const U32 srcRowBytes = width * AwSourceTraits <SrcFormat>::BytesPerPixel;
+		const U32 dstRowBytes = width * AwTextureTraits <DstFormat>::BytesPerPixel;
+
+		if (Mode == AwPixelCopy::Copy && srcRowBytes == dstRowBytes)
+		{
+			if (srcPitch == srcRowBytes && dstPitch == dstRowBytes)
+			{
+				dMemcpy (dst, src, dstRowBytes * height);
+				return;
+			}
+
+			for (U32 y = 0; y < height; y++)
+			{
+				dMemcpy (dst + y * dstPitch, src + y * srcPitch, dstRowBytes);
+			}
+			return;
+		}
+
+		AwPixelCopy::RowFunc copyRow = AwPixelCopy::getRowFunc (Mode);
+		for (U32 y = 0; y < height; y++)
+		{
+			copyRow (dst + y * dstPitch, src + y * srcPitch, width);
+		}
+	}
+};
\ No newline at end of file
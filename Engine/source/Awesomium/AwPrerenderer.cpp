@@ -0,0 +1,233 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwPrerenderer.h"
+#include "AwTextureTarget.h"
+#include "AwContext.h"
+#include "AwManager.h"
+#include "console/engineAPI.h"
+#include "console/simSet.h"
+#include "platform/threads/threadPool.h"
+
+#include <Awesomium/WebCore.h>
+
+Vector <SimObjectPtr <AwTextureTarget> > AwPrerenderer::sQueue;
+Vector <AwPrerenderer::Job> AwPrerenderer::sJobs;
+U32 AwPrerenderer::sNumWritten												= 0;
+U32 AwPrerenderer::sNumFailed												= 0;
+
+U32 AwPrerenderer::queueSet (SimSet *set)
+{
+	U32 numQueued = sQueue.size ();
+	if (set)
+	{
+		collect (set);
+	}
+	else
+	{
+		const Vector <AwTextureTarget *> &targets = AwManager::getTargets ();
+		for (U32 i = 0; i < targets.size (); i++)
+		{
+			queue (targets [i]);
+		}
+	}
+
+	return sQueue.size () - numQueued;
+}
+
+void AwPrerenderer::collect (SimSet *set)
+{
+	for (SimSet::iterator iter = set->begin (); iter != set->end (); iter++)
+	{
+		if (AwTextureTarget *target = dynamic_cast <AwTextureTarget *> (*iter))
+		{
+			queue (target);
+		}
+		else if (SimSet *subSet = dynamic_cast <SimSet *> (*iter))
+		{
+			collect (subSet);
+		}
+	}
+}
+
+void AwPrerenderer::queue (AwTextureTarget *target)
+{
+	// The cache is keyed by content, so an existing file is already up to date.
+	if (!target->usesBitmapCache () || target->hasCacheFile ())
+	{
+		return;
+	}
+
+	for (U32 i = 0; i < sQueue.size (); i++)
+	{
+		if (sQueue [i] == target)
+		{
+			return;
+		}
+	}
+	for (U32 i = 0; i < sJobs.size (); i++)
+	{
+		if (sJobs [i].target == target)
+		{
+			return;
+		}
+	}
+
+	sQueue.push_back (target);
+}
+
+void AwPrerenderer::process ()
+{
+	if (isDone ())
+	{
+		return;
+	}
+
+	U32 numViews = getMax (Con::getIntVariable ("$pref::Awesomium::PrerenderViews", 4), 1);
+	U32 settleTime = Con::getIntVariable ("$pref::Awesomium::PrerenderSettleTime", 500);
+	U32 timeout = Con::getIntVariable ("$pref::Awesomium::PrerenderTimeout", 30000);
+	U32 time = Platform::getRealMilliseconds ();
+
+	// Hand out the free views.
+	while (sJobs.size () < numViews && !sQueue.empty ())
+	{
+		AwTextureTarget *target = sQueue.first ();
+		sQueue.pop_front ();
+		if (!target)
+		{
+			continue;
+		}
+
+		Job job;
+		job.target = target;
+		job.context = target->createPrerenderContext ();
+		job.startTime = time;
+		job.readyTime = 0;
+		sJobs.push_back (job);
+	}
+
+	for (S32 i = sJobs.size () - 1; i >= 0; i--)
+	{
+		Job &job = sJobs [i];
+		if (!job.target)
+		{
+			finishJob (i, false);
+			continue;
+		}
+
+		if (time - job.startTime > timeout)
+		{
+			Con::warnf ("AwPrerenderer - '%s' timed out", job.target->getName ());
+			finishJob (i, false);
+			continue;
+		}
+
+		if (job.context->isLoading ())
+		{
+			job.readyTime = 0;
+			continue;
+		}
+
+		if (job.readyTime == 0)
+		{
+			job.readyTime = time;
+		}
+
+		// Keep uploading what the view paints, so the snapshot is complete once the page has settled.
+		if (job.context->isUpdateReady ())
+		{
+			job.context->finishUpdate ();
+		}
+		job.context->beginUpdate ();
+
+		if (time - job.readyTime < settleTime || job.context->getFrameNumber () == 0)
+		{
+			continue;
+		}
+
+		finishJob (i, job.target->queueCacheWrite (job.context));
+	}
+
+	if (isDone ())
+	{
+		Con::printf ("AwPrerenderer - Wrote %i cache files, %i failed", sNumWritten, sNumFailed);
+		sNumWritten = 0;
+		sNumFailed = 0;
+	}
+}
+
+void AwPrerenderer::finishJob (U32 index, bool isWritten)
+{
+	if (isWritten)
+	{
+		sNumWritten++;
+	}
+	else
+	{
+		sNumFailed++;
+	}
+
+	delete sJobs [index].context;
+	sJobs.erase (index);
+}
+
+void AwPrerenderer::cancel ()
+{
+	for (U32 i = 0; i < sJobs.size (); i++)
+	{
+		delete sJobs [i].context;
+	}
+
+	sJobs.clear ();
+	sQueue.clear ();
+	sNumWritten = 0;
+	sNumFailed = 0;
+}
+
+DefineEngineFunction (awPrerenderCache, S32, (const char *setName, bool wait), ("", false),
+	"@brief Renders the pages of the AwTextureTargets in a set (and its subsets) into the bitmap cache ahead of time. "
+	"Targets which don't use the bitmap cache or already have a cache file are skipped. Single-frame targets with a cache file never start a view.\n\n"
+	"@param setName The set to search, like MissionGroup. All targets if empty.\n"
+	"@param wait If set, returns only once every page has been written. Useful when running from the command line.\n"
+	"@return How many targets were queued.")
+{
+	SimSet *set = nullptr;
+	if (setName && setName [0] && !Sim::findObject (setName, set))
+	{
+		Con::errorf ("awPrerenderCache - Could not find set '%s'", setName);
+		return 0;
+	}
+
+	U32 numQueued = AwPrerenderer::queueSet (set);
+	if (wait && Awesomium::WebCore::instance ())
+	{
+		while (!AwPrerenderer::isDone ())
+		{
+			Awesomium::WebCore::instance ()->Update ();
+			AwPrerenderer::process ();
+			Platform::sleep (5);
+		}
+
+		// The files are written by the thread pool.
+		ThreadPool::GLOBAL ().flushWorkItems ();
+	}
+
+	return numQueued;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Core/Util/tVector.h"
+#include "console/simObject.h"
+
+class AwContext;
+class AwTextureTarget;
+class SimSet;
+
+/*
+ *  AwPrerenderer
+ *  -----------------------------------------------------------------------------------------------
+ *	Fills the bitmap cache ahead of time, so targets don't have to load their pages before showing
+ *	something, and single-frame targets never start a view at all. Targets are rendered through a
+ *	small pool of views in parallel ($pref::Awesomium::PrerenderViews). Each page gets a moment
+ *	after loading to finish painting before it's captured. Driven by AwManager every frame, or by
+ *	awPrerenderCache () itself when it's asked to wait.
+ */
+class AwPrerenderer
+{
+	struct Job
+	{
+		SimObjectPtr <AwTextureTarget> target;
+		AwContext *context;
+		U32 startTime;										// When the page started loading.
+		U32 readyTime;										// When the page finished loading. 0 while it's loading.
+	};
+
+	static Vector <SimObjectPtr <AwTextureTarget> > sQueue;	// Targets waiting for a view.
+	static Vector <Job> sJobs;								// Targets being rendered.
+	static U32 sNumWritten;									// Cache files written since the queue was last empty.
+	static U32 sNumFailed;									// Targets which timed out or couldn't be captured since the queue was last empty.
+
+	static void collect (SimSet *set);						// Queues the targets in the set and its subsets.
+	static void queue (AwTextureTarget *target);			// Queues the target unless it doesn't use the cache, already has a file or is queued already.
+	static void finishJob (U32 index, bool isWritten);
+
+public:
+	static U32 queueSet (SimSet *set);						// Queues the targets in the set (or all targets if null) which use the bitmap cache. Returns how many were queued.
+	static void process ();									// Starts, advances and finishes jobs. Called once per frame.
+	static bool isDone () { return sQueue.empty () && sJobs.empty (); }
+	static void cancel ();									// Drops all queued and running jobs.
+};
\ No newline at end of file
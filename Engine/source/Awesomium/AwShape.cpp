@@ -48,17 +48,28 @@
 #include "SFX/SFXSystem.h"
 #include "AwManager.h"
 #include "AwTextureCursor.h"
+#include "renderInstance/renderPassManager.h"
+#include "gfx/primBuilder.h"
+#include "collision/optimizedPolyList.h"
 
 IMPLEMENT_CO_NETOBJECT_V1 (AwShape);
 
 AwShape *AwShape::sMouseInputShape = nullptr;
+GFXStateBlockRef AwShape::sCursorStateBlock;
 
 AwShape::AwShape ()
 {
 	mTypeMask |= StaticObjectType | StaticShapeObjectType | AwShapeObjectType;
 	mMatInstance = nullptr;
+	mDenseIndex = AwDenseList <AwShape>::InvalidIndex;
+	mIsInGrid = false;
+	mGridQueryMark = 0;
+	mLastVisibleFrame = 0;
 	mTextureTarget = nullptr;
 	mIsMouseDown = false;
+	mHasCursorFrame = false;
+	mHasHitTriangles = false;
+	mLastHitTriangle = -1;
 }
 
 bool AwShape::onAdd ()
@@ -110,6 +121,9 @@ void AwShape::updateMapping ()
 {
 	mMatInstance = NULL;
 	mTextureTarget = NULL;
+	mHitTriangles.clear ();
+	mHasHitTriangles = false;
+	mLastHitTriangle = -1;
 
 	// Go trough all materials on the shape and map them to their texture targets.
 	if (!mShapeInstance)
@@ -203,6 +217,170 @@ void AwShape::setIsMouseDown (bool isMouseDown)
 }
 
 //----------------------------------------------------------------------------
+void AwShape::buildHitTriangles ()
+{
+	mHitTriangles.clear ();
+	mLastHitTriangle = -1;
+	mHasHitTriangles = true;
+
+	if (!mShapeInstance || !mMatInstance)
+	{
+		return;
+	}
+
+	// Same detail level as castRayOpcode uses. The list is left with an identity transform, so the points end up in shape space.
+	OptimizedPolyList polyList;
+	mShapeInstance->buildPolyList (&polyList, 0);
+
+	// Faces of other materials (like the frame around a screen) are kept as well, so they block picks like they do for castRayOpcode.
+	bool hasPageTriangles = false;
+	for (U32 i = 0; i < polyList.mPolyList.size (); i++)
+	{
+		const OptimizedPolyList::Poly &poly = polyList.mPolyList [i];
+		if (poly.vertexCount < 3)
+		{
+			continue;
+		}
+
+		bool isOccluder = poly.material < 0 || polyList.mMaterialList [poly.material] != mMatInstance;
+
+		U32 numTriangles = poly.type == OptimizedPolyList::TriangleList ? poly.vertexCount / 3 : poly.vertexCount - 2;
+		for (U32 j = 0; j < numTriangles; j++)
+		{
+			// Indices into the poly's run of vertices.
+			U32 corners [3];
+			if (poly.type == OptimizedPolyList::TriangleList)
+			{
+				corners [0] = j * 3;
+				corners [1] = j * 3 + 1;
+				corners [2] = j * 3 + 2;
+			}
+			else if (poly.type == OptimizedPolyList::TriangleStrip)
+			{
+				corners [0] = j;
+				corners [1] = j & 1 ? j + 2 : j + 1;
+				corners [2] = j & 1 ? j + 1 : j + 2;
+			}
+			else
+			{
+				corners [0] = 0;
+				corners [1] = j + 1;
+				corners [2] = j + 2;
+			}
+
+			HitTriangle tri;
+			Point3F points [3];
+			bool isValid = true;
+			for (U32 k = 0; k < 3; k++)
+			{
+				const OptimizedPolyList::VertIndex &vert = polyList.mVertexList [polyList.mIndexList [poly.vertexStart + corners [k]]];
+				if (vert.vertIdx < 0)
+				{
+					isValid = false;
+					break;
+				}
+
+				points [k] = polyList.mPoints [vert.vertIdx];
+				if (isOccluder)
+				{
+					tri.texCoord [k].set (0.0f, 0.0f);
+				}
+				else if (vert.uv0Idx >= 0 && vert.uv0Idx < (S32)polyList.mUV0s.size ())
+				{
+					tri.texCoord [k] = polyList.mUV0s [vert.uv0Idx];
+				}
+				else
+				{
+					isValid = false;
+					break;
+				}
+			}
+
+			if (!isValid)
+			{
+				continue;
+			}
+
+			tri.origin = points [0];
+			tri.edgeA = points [1] - points [0];
+			tri.edgeB = points [2] - points [0];
+			tri.isOccluder = isOccluder;
+			mHitTriangles.push_back (tri);
+			hasPageTriangles |= !isOccluder;
+		}
+	}
+
+	// Without a single face of the page, fall back to castRayOpcode.
+	if (!hasPageTriangles)
+	{
+		mHitTriangles.clear ();
+	}
+}
+
+bool AwShape::castHitTriangle (const HitTriangle &tri, const Point3F &start, const VectorF &dir, F32 maxT, F32 &t, Point2F &texCoord)
+{
+	// Moller-Trumbore. Both sides count, like they do for castRayOpcode.
+	VectorF p = mCross (dir, tri.edgeB);
+	F32 det = mDot (tri.edgeA, p);
+	if (mFabs (det) < 1e-10f)
+	{
+		return false;
+	}
+
+	F32 invDet = 1.0f / det;
+	VectorF s = start - tri.origin;
+	F32 u = mDot (s, p) * invDet;
+	if (u < 0.0f || u > 1.0f)
+	{
+		return false;
+	}
+
+	VectorF q = mCross (s, tri.edgeA);
+	F32 v = mDot (dir, q) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+	{
+		return false;
+	}
+
+	t = mDot (tri.edgeB, q) * invDet;
+	if (t < 0.0f || t > maxT)
+	{
+		return false;
+	}
+
+	texCoord = (tri.texCoord [0] * (1.0f - u - v)) + (tri.texCoord [1] * u) + (tri.texCoord [2] * v);
+	return true;
+}
+
+S32 AwShape::castHitTriangles (const Point3F &localStart, const Point3F &localEnd, F32 &t, Point2F &texCoord)
+{
+	VectorF dir = localEnd - localStart;
+
+	// While the cursor hovers, it almost always stays on the face it was on last time. Starting with that hit, the other faces only
+	// have to be tested up to its distance, which rejects most of them before the texture coordinates are interpolated.
+	S32 nearest = -1;
+	if (mLastHitTriangle >= 0 && mLastHitTriangle < (S32)mHitTriangles.size () && castHitTriangle (mHitTriangles [mLastHitTriangle], localStart, dir, 1.0f, t, texCoord))
+	{
+		nearest = mLastHitTriangle;
+	}
+
+	for (U32 i = 0; i < mHitTriangles.size (); i++)
+	{
+		F32 triT;
+		Point2F triTexCoord;
+		if ((S32)i != nearest && castHitTriangle (mHitTriangles [i], localStart, dir, nearest < 0 ? 1.0f : t, triT, triTexCoord) && (nearest < 0 || triT < t))
+		{
+			nearest = i;
+			t = triT;
+			texCoord = triTexCoord;
+		}
+	}
+
+	// A face of another material in front of the page blocks the pick.
+	mLastHitTriangle = nearest;
+	return nearest >= 0 && !mHitTriangles [nearest].isOccluder ? nearest : -1;
+}
+
 AwTextureTarget *AwShape::processAwesomiumHit (const Point3F &start, const Point3F &end)
 {
 	if (!mTextureTarget)
@@ -218,31 +396,231 @@ AwTextureTarget *AwShape::processAwesomiumHit (const Point3F &start, const Point
 	mat.mulP (start, &localStart);
 	mat.mulP (end, &localEnd);
 
-	RayInfo info;
-	info.generateTexCoord = true;
-	if (!mShapeInstance || !mShapeInstance->castRayOpcode (0, localStart, localEnd, &info))
+	if (!mHasHitTriangles)
 	{
-		return NULL;
+		buildHitTriangles ();
 	}
 
-	if (info.texCoord.x != -1 && info.texCoord.y != -1 && info.material == mMatInstance)
+	Point2I resolution = mTextureTarget->getResolution ();
+	if (!mHitTriangles.empty ())
 	{
-		Point2I pnt (info.texCoord.x * mTextureTarget->getResolution ().x, info.texCoord.y * mTextureTarget->getResolution ().y);
-		
+		F32 t;
+		Point2F texCoord;
+		S32 hit = castHitTriangles (localStart, localEnd, t, texCoord);
+		if (hit < 0)
+		{
+			return NULL;
+		}
+
+		Point2I pnt (texCoord.x * resolution.x, texCoord.y * resolution.y);
 		AwManager::sCursor->setPosition (pnt);
 
-		if (mIsMouseDown)
+		if (mTextureTarget->isCursorOverlay ())
 		{
-			mTextureTarget->injectMouseDown ();
+			updateCursorFrame (mHitTriangles [hit], localStart + ((localEnd - localStart) * t), pnt);
 		}
-		else
+	}
+	else
+	{
+		// No texture coordinates could be read from the meshes, so let the collision code find them.
+		RayInfo info;
+		info.generateTexCoord = true;
+		if (!mShapeInstance || !mShapeInstance->castRayOpcode (0, localStart, localEnd, &info))
 		{
-			mTextureTarget->injectMouseUp ();
+			return NULL;
+		}
+
+		if (info.texCoord.x == -1 || info.texCoord.y == -1 || info.material != mMatInstance)
+		{
+			return NULL;
+		}
+
+		Point2I pnt (info.texCoord.x * resolution.x, info.texCoord.y * resolution.y);
+		AwManager::sCursor->setPosition (pnt);
+
+		if (mTextureTarget->isCursorOverlay ())
+		{
+			updateCursorFrame (localStart, localEnd, info, pnt);
+		}
+	}
+
+	if (mIsMouseDown)
+	{
+		mTextureTarget->injectMouseDown ();
+	}
+	else
+	{
+		mTextureTarget->injectMouseUp ();
+	}
+
+	return mTextureTarget;
+}
+
+void AwShape::updateCursorFrame (const Point3F &localStart, const Point3F &localEnd, const RayInfo &info, const Point2I &pnt)
+{
+	// Cast two more rays, offset a little along the surface, and see how the texture coordinates change.
+	VectorF normal = info.normal;
+	normal.normalizeSafe ();
+	VectorF axisA = mCross (normal, mFabs (normal.z) < 0.9f ? VectorF (0.0f, 0.0f, 1.0f) : VectorF (1.0f, 0.0f, 0.0f));
+	axisA.normalizeSafe ();
+	VectorF axisB = mCross (normal, axisA);
+
+	F32 step = mObjBox.len_max () * 0.01f;
+	RayInfo infoA, infoB;
+	infoA.generateTexCoord = true;
+	infoB.generateTexCoord = true;
+	if (!mShapeInstance->castRayOpcode (0, localStart + axisA * step, localEnd + axisA * step, &infoA) || infoA.material != mMatInstance ||
+		!mShapeInstance->castRayOpcode (0, localStart + axisB * step, localEnd + axisB * step, &infoB) || infoB.material != mMatInstance)
+	{
+		// Probably too close to an edge. Keep using the previous frame.
+		return;
+	}
+
+	Point2F deltaA = infoA.texCoord - info.texCoord;
+	Point2F deltaB = infoB.texCoord - info.texCoord;
+	F32 det = (deltaA.x * deltaB.y) - (deltaB.x * deltaA.y);
+	if (mFabs (det) < 1e-8f)
+	{
+		return;
+	}
+
+	// Invert the mapping to find the surface steps which move one unit along U and V.
+	VectorF stepU = ((axisA * deltaB.y) - (axisB * deltaA.y)) * (step / det);
+	VectorF stepV = ((axisB * deltaA.x) - (axisA * deltaB.x)) * (step / det);
+
+	Point2I resolution = mTextureTarget->getResolution ();
+	mCursorTexelU = stepU / (F32)resolution.x;
+	mCursorTexelV = stepV / (F32)resolution.y;
+	mCursorHitPoint = info.point;
+	mCursorHitNormal = normal;
+	mCursorHitPixel = pnt;
+	mHasCursorFrame = true;
+}
+
+void AwShape::updateCursorFrame (const HitTriangle &tri, const Point3F &point, const Point2I &pnt)
+{
+	Point2F deltaA = tri.texCoord [1] - tri.texCoord [0];
+	Point2F deltaB = tri.texCoord [2] - tri.texCoord [0];
+	F32 det = (deltaA.x * deltaB.y) - (deltaB.x * deltaA.y);
+	VectorF normal = mCross (tri.edgeA, tri.edgeB);
+	if (mFabs (det) < 1e-8f || normal.isZero ())
+	{
+		return;
+	}
+
+	normal.normalize ();
+
+	// Invert the texture mapping of the triangle to find the surface steps which move one unit along U and V.
+	VectorF stepU = ((tri.edgeA * deltaB.y) - (tri.edgeB * deltaA.y)) / det;
+	VectorF stepV = ((tri.edgeB * deltaA.x) - (tri.edgeA * deltaB.x)) / det;
+
+	Point2I resolution = mTextureTarget->getResolution ();
+	mCursorTexelU = stepU / (F32)resolution.x;
+	mCursorTexelV = stepV / (F32)resolution.y;
+	mCursorHitPoint = point;
+	mCursorHitNormal = normal;
+	mCursorHitPixel = pnt;
+	mHasCursorFrame = true;
+}
+
+void AwShape::setTransform (const MatrixF &mat)
+{
+	Parent::setTransform (mat);
+	if (isClientObject ())
+	{
+		AwManager::updateShape (this);
+	}
+}
+
+void AwShape::setScale (const VectorF &scale)
+{
+	Parent::setScale (scale);
+	if (isClientObject ())
+	{
+		AwManager::updateShape (this);
+	}
+}
+
+void AwShape::prepRenderImage (SceneRenderState *state)
+{
+	Parent::prepRenderImage (state);
+
+	// Culled shapes never get here, so this tells the target it's on screen.
+	if (mTextureTarget && state->isDiffusePass ())
+	{
+		mTextureTarget->markVisible ();
+		if (mLastVisibleFrame != AwManager::getFrameNumber ())
+		{
+			mLastVisibleFrame = AwManager::getFrameNumber ();
+			mTextureTarget->reportVisibleInstance (AwManager::getProjectedArea (this, state));
 		}
+	}
 
-		return mTextureTarget;
+	if (sMouseInputShape != this || !mHasCursorFrame || !mTextureTarget || !mTextureTarget->isCursorOverlay () || !state->isDiffusePass ())
+	{
+		return;
 	}
-	return NULL;
+
+	ObjectRenderInst *ri = state->getRenderPass ()->allocInst <ObjectRenderInst> ();
+	ri->renderDelegate.bind (this, &AwShape::renderCursorOverlay);
+	ri->type = RenderPassManager::RIT_ObjectTranslucent;
+	ri->translucentSort = true;
+	ri->defaultKey = 0;
+	ri->defaultKey2 = 0;
+	state->getRenderPass ()->addInst (ri);
+}
+
+void AwShape::renderCursorOverlay (ObjectRenderInst *ri, SceneRenderState *state, BaseMatInstance *overrideMat)
+{
+	if (overrideMat || !mTextureTarget)
+	{
+		return;
+	}
+
+	GFXTexHandle texture = mTextureTarget->getCursorTexture ();
+	if (!texture)
+	{
+		return;
+	}
+
+	if (!sCursorStateBlock)
+	{
+		GFXStateBlockDesc desc;
+		desc.setBlend (true, GFXBlendSrcAlpha, GFXBlendInvSrcAlpha);
+		desc.setZReadWrite (true, false);
+		desc.setCullMode (GFXCullNone);
+		desc.samplersDefined = true;
+		desc.samplers [0] = GFXSamplerStateDesc::getClampLinear ();
+		sCursorStateBlock = GFX->createStateBlock (desc);
+	}
+
+	// Place the quad relative to the last hit, using the interpolated cursor position. Lift it a little off the surface to avoid z-fighting.
+	Point2I pos = AwManager::sCursor->getRenderPosition () - mCursorHitPixel;
+	Point3F origin = mCursorHitPoint + mCursorHitNormal * (mObjBox.len_max () * 0.001f);
+	VectorF width = mCursorTexelU * (F32)texture.getWidth ();
+	VectorF height = mCursorTexelV * (F32)texture.getHeight ();
+	Point3F topLeft = origin + (mCursorTexelU * (F32)pos.x) + (mCursorTexelV * (F32)pos.y);
+
+	GFXTransformSaver saver;
+	MatrixF mat = getRenderTransform ();
+	mat.scale (getScale ());
+	GFX->multWorld (mat);
+
+	GFX->setStateBlock (sCursorStateBlock);
+	GFX->setTexture (0, texture);
+	GFX->setupGenericShaders (GFXDevice::GSModColorTexture);
+
+	PrimBuild::color (ColorI::WHITE);
+	PrimBuild::begin (GFXTriangleStrip, 4);
+		PrimBuild::texCoord2f (0.0f, 0.0f);
+		PrimBuild::vertex3fv (topLeft);
+		PrimBuild::texCoord2f (1.0f, 0.0f);
+		PrimBuild::vertex3fv (topLeft + width);
+		PrimBuild::texCoord2f (0.0f, 1.0f);
+		PrimBuild::vertex3fv (topLeft + height);
+		PrimBuild::texCoord2f (1.0f, 1.0f);
+		PrimBuild::vertex3fv (topLeft + width + height);
+	PrimBuild::end ();
 }
 
 void AwShape::execJavaScript (const String &script)
@@ -256,4 +634,16 @@ void AwShape::execJavaScript (const String &script)
 DefineEngineMethod (AwShape, execJavaScript, void, (const char *script),, "")
 {
 	object->execJavaScript (script);
+}
+
+DefineEngineFunction (awPickShape, S32, (Point3F start, Point3F end),,
+	"@brief Finds the nearest AwShape whose page is hit by the segment, moves the cursor onto the page and gives the shape mouse input. "
+	"If no page is hit, no shape keeps mouse input.\n\n"
+	"@param start The start of the segment, usually the eye of the control object.\n"
+	"@param end The end of the segment.\n"
+	"@return The id of the shape which was hit, or 0.")
+{
+	AwShape *shape = AwManager::pickShape (start, end);
+	AwShape::setMouseInputShape (shape);
+	return shape ? shape->getId () : 0;
 }
\ No newline at end of file
@@ -25,11 +25,14 @@
 #include "core/resource.h"
 #include "sim/netStringTable.h"
 #include "ts/tsShape.h"
+#include "gfx/gfxStateBlock.h"
 
 #include "T3D/TSStatic.h"
+#include "AwDenseList.h"
 
 class AwTextureTarget;
 class AwContext;
+class ObjectRenderInst;
 
 /*
  *  AwShape
@@ -42,14 +45,49 @@ class AwShape : public TSStatic
 	typedef TSStatic Parent;
 
 	friend class AwManager;
+	friend class AwDenseList <AwShape>;
+	friend class AwShapeGrid;
+
+	struct HitTriangle																	// A face of the shape, in object space.
+	{
+		Point3F origin;
+		VectorF edgeA;																	// From origin to the second corner.
+		VectorF edgeB;																	// From origin to the third corner.
+		Point2F texCoord [3];
+		bool isOccluder;																// Set for faces of other materials. They only block picks, so their texture coordinates are zero.
+	};
 
 	static AwShape *sMouseInputShape;
+	U32 mDenseIndex;									// Position in AwManager's list of shapes.
+	bool mIsInGrid;																		// Set while the shape is in AwManager's shape grid.
+	Point3I mGridMin;																	// First grid cell covered by the world box.
+	Point3I mGridMax;																	// Last grid cell covered by the world box.
+	U32 mGridQueryMark;																	// The last grid query which returned this shape.
+	U32 mLastVisibleFrame;																// The last frame (see AwManager::getFrameNumber) this shape survived culling.
 	BaseMatInstance *mMatInstance;
 	AwTextureTarget *mTextureTarget;
 	bool mIsMouseDown;																	// Used to track if a mouse button has been used.
 
+	bool mHasCursorFrame;																// Set when the values below are valid and the cursor overlay can be drawn.
+	Point3F mCursorHitPoint;															// Object space point which was under the cursor at the last hit.
+	VectorF mCursorHitNormal;															// Object space normal at the last hit.
+	Point2I mCursorHitPixel;															// The pixel which was under the cursor at the last hit.
+	VectorF mCursorTexelU;																// Object space step which moves one pixel to the right on the texture.
+	VectorF mCursorTexelV;																// Object space step which moves one pixel down on the texture.
+	static GFXStateBlockRef sCursorStateBlock;
+
+	Vector <HitTriangle> mHitTriangles;													// The faces picking is tested against. Built on the first pick after the mapping changes.
+	bool mHasHitTriangles;																// Set once mHitTriangles is built. If it's still empty, the shape has no usable texture coordinates and picking falls back to castRayOpcode.
+	S32 mLastHitTriangle;																// The triangle hit by the last pick. Tested first, since the cursor usually stays on the same face. -1 if none.
+
 	void onGainMouseInput ();															// When mouse input is gained this gets called. Is used to play a sound.
 	void onLoseMouseInput ();															// When mouse input is lost this gets called. Is used to play a sound.
+	void updateCursorFrame (const Point3F &localStart, const Point3F &localEnd, const RayInfo &info, const Point2I &pnt); // Finds how pixels on the texture map to the surface around the hit, for the cursor overlay.
+	void updateCursorFrame (const HitTriangle &tri, const Point3F &point, const Point2I &pnt); // Same as above, but exact, taken from the triangle which was hit.
+	void buildHitTriangles ();															// Collects the faces of the shape. Those which use mMatInstance keep their texture coordinates.
+	S32 castHitTriangles (const Point3F &localStart, const Point3F &localEnd, F32 &t, Point2F &texCoord); // Returns the nearest triangle the segment hits, or -1 if none or the nearest is an occluder.
+	static bool castHitTriangle (const HitTriangle &tri, const Point3F &start, const VectorF &dir, F32 maxT, F32 &t, Point2F &texCoord); // Ray/triangle test. t is a fraction of dir, and hits beyond maxT are ignored.
+	void renderCursorOverlay (ObjectRenderInst *ri, SceneRenderState *state, BaseMatInstance *overrideMat); // Draws the cursor bitmap as a quad on top of the shape.
 
 public:
 	void updateMapping ();
@@ -58,6 +96,9 @@ public:
 	void setIsMouseDown (bool isMouseDown);
 	bool onAdd ();
 	void onRemove ();
+	void prepRenderImage (SceneRenderState *state);
+	void setTransform (const MatrixF &mat);												// Keeps the shape grid in sync when the shape moves.
+	void setScale (const VectorF &scale);												// Keeps the shape grid in sync when the shape is scaled.
 	void onResourceChanged (const Torque::Path &path);									// Gets called when the resource associated with this AwShape changes.
 	AwTextureTarget *getTextureTarget () { return mTextureTarget; }						// Returns the AwTextureTarget associated with this AwShape.
 
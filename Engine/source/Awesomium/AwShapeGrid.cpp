@@ -0,0 +1,264 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwShapeGrid.h"
+#include "AwShape.h"
+
+AwShapeGrid::AwShapeGrid ()
+{
+	mCellSize = 16.0f;
+	mQueryMark = 0;
+}
+
+void AwShapeGrid::setCellSize (F32 cellSize)
+{
+	if (mCells.size () == 0 && cellSize > 0.0f)
+	{
+		mCellSize = cellSize;
+	}
+}
+
+Point3I AwShapeGrid::getCell (const Point3F &pnt) const
+{
+	// Points far outside any level (like the corners of a huge query) are clamped, so the conversion can't overflow.
+	const F32 maxCell = 1 << 30;
+	return Point3I ((S32)mClampF (mFloor (pnt.x / mCellSize), -maxCell, maxCell),
+		(S32)mClampF (mFloor (pnt.y / mCellSize), -maxCell, maxCell),
+		(S32)mClampF (mFloor (pnt.z / mCellSize), -maxCell, maxCell));
+}
+
+void AwShapeGrid::getCellRange (AwShape *shape, Point3I &min, Point3I &max) const
+{
+	const Box3F &box = shape->getWorldBox ();
+	min = getCell (box.minExtents);
+	max = getCell (box.maxExtents);
+}
+
+void AwShapeGrid::addToCells (AwShape *shape)
+{
+	for (S32 z = shape->mGridMin.z; z <= shape->mGridMax.z; z++)
+	{
+		for (S32 y = shape->mGridMin.y; y <= shape->mGridMax.y; y++)
+		{
+			for (S32 x = shape->mGridMin.x; x <= shape->mGridMax.x; x++)
+			{
+				Cell &cell = mCells [getKey (x, y, z)];
+				if (!cell.contains (shape))
+				{
+					cell.push_back (shape);
+				}
+			}
+		}
+	}
+}
+
+void AwShapeGrid::removeFromCells (AwShape *shape)
+{
+	for (S32 z = shape->mGridMin.z; z <= shape->mGridMax.z; z++)
+	{
+		for (S32 y = shape->mGridMin.y; y <= shape->mGridMax.y; y++)
+		{
+			for (S32 x = shape->mGridMin.x; x <= shape->mGridMax.x; x++)
+			{
+				U32 key = getKey (x, y, z);
+				Map <U32, Cell>::Iterator iter = mCells.find (key);
+				if (iter == mCells.end ())
+				{
+					continue;
+				}
+
+				// Cells hold few shapes, so a search is fine here.
+				iter->value.remove (shape);
+				if (iter->value.empty ())
+				{
+					mCells.erase (key);
+				}
+			}
+		}
+	}
+}
+
+void AwShapeGrid::insert (AwShape *shape)
+{
+	if (shape->mIsInGrid)
+	{
+		return;
+	}
+
+	getCellRange (shape, shape->mGridMin, shape->mGridMax);
+	addToCells (shape);
+	shape->mIsInGrid = true;
+}
+
+void AwShapeGrid::remove (AwShape *shape)
+{
+	if (!shape->mIsInGrid)
+	{
+		return;
+	}
+
+	removeFromCells (shape);
+	shape->mIsInGrid = false;
+}
+
+void AwShapeGrid::update (AwShape *shape)
+{
+	if (!shape->mIsInGrid)
+	{
+		return;
+	}
+
+	Point3I min, max;
+	getCellRange (shape, min, max);
+	if (min == shape->mGridMin && max == shape->mGridMax)
+	{
+		return;
+	}
+
+	removeFromCells (shape);
+	shape->mGridMin = min;
+	shape->mGridMax = max;
+	addToCells (shape);
+}
+
+void AwShapeGrid::collectCell (S32 x, S32 y, S32 z, Vector <AwShape *> &result)
+{
+	Map <U32, Cell>::Iterator iter = mCells.find (getKey (x, y, z));
+	if (iter == mCells.end ())
+	{
+		return;
+	}
+
+	const Cell &cell = iter->value;
+	for (U32 i = 0; i < cell.size (); i++)
+	{
+		if (cell [i]->mGridQueryMark != mQueryMark)
+		{
+			cell [i]->mGridQueryMark = mQueryMark;
+			result.push_back (cell [i]);
+		}
+	}
+}
+
+void AwShapeGrid::findInRadius (const Point3F &center, F32 radius, Vector <AwShape *> &result)
+{
+	mQueryMark++;
+	U32 first = result.size ();
+
+	Point3I min = getCell (center - Point3F (radius, radius, radius));
+	Point3I max = getCell (center + Point3F (radius, radius, radius));
+	// A large radius covers more cells than even a U64 can count, so the product is only estimated. It just has to be compared.
+	F64 numCells = ((F64)max.x - min.x + 1.0) * ((F64)max.y - min.y + 1.0) * ((F64)max.z - min.z + 1.0);
+
+	if (numCells > (F64)mCells.size ())
+	{
+		// The sphere covers more cells than there are occupied ones, so it's cheaper to look at those.
+		for (Map <U32, Cell>::Iterator iter = mCells.begin (); iter != mCells.end (); iter++)
+		{
+			const Cell &cell = iter->value;
+			for (U32 i = 0; i < cell.size (); i++)
+			{
+				if (cell [i]->mGridQueryMark != mQueryMark)
+				{
+					cell [i]->mGridQueryMark = mQueryMark;
+					result.push_back (cell [i]);
+				}
+			}
+		}
+	}
+	else
+	{
+		for (S32 z = min.z; z <= max.z; z++)
+		{
+			for (S32 y = min.y; y <= max.y; y++)
+			{
+				for (S32 x = min.x; x <= max.x; x++)
+				{
+					collectCell (x, y, z, result);
+				}
+			}
+		}
+	}
+
+	// The cells only roughly cover the sphere.
+	for (S32 i = result.size () - 1; i >= (S32)first; i--)
+	{
+		if (result [i]->getWorldBox ().getDistanceToPoint (center) > radius)
+		{
+			result.erase_fast (i);
+		}
+	}
+}
+
+void AwShapeGrid::findAlongRay (const Point3F &start, const Point3F &end, Vector <AwShape *> &result)
+{
+	enum
+	{
+		MaxCellsPerRay = 4096								// Guards against rays which are very long compared to the cells.
+	};
+
+	mQueryMark++;
+
+	// Walk the cells the ray passes through, in order (Amanatides & Woo).
+	Point3I startCell = getCell (start);
+	Point3I endCell = getCell (end);
+	S32 cell [3] = { startCell.x, startCell.y, startCell.z };
+	S32 last [3] = { endCell.x, endCell.y, endCell.z };
+	F32 origin [3] = { start.x, start.y, start.z };
+	F32 dir [3] = { end.x - start.x, end.y - start.y, end.z - start.z };
+
+	S32 step [3];
+	F32 tMax [3];
+	F32 tDelta [3];
+	for (U32 i = 0; i < 3; i++)
+	{
+		if (mFabs (dir [i]) < 0.000001f)
+		{
+			step [i] = 0;
+			tMax [i] = F32_MAX;
+			tDelta [i] = F32_MAX;
+			continue;
+		}
+
+		// tMax is where (as a fraction of the ray) the ray crosses the first cell border on this axis.
+		step [i] = dir [i] > 0.0f ? 1 : -1;
+		F32 border = (cell [i] + (step [i] > 0 ? 1 : 0)) * mCellSize;
+		tMax [i] = (border - origin [i]) / dir [i];
+		tDelta [i] = mCellSize / mFabs (dir [i]);
+	}
+
+	for (U32 n = 0; n < MaxCellsPerRay; n++)
+	{
+		collectCell (cell [0], cell [1], cell [2], result);
+		if (cell [0] == last [0] && cell [1] == last [1] && cell [2] == last [2])
+		{
+			break;
+		}
+
+		U32 axis = tMax [0] < tMax [1] ? (tMax [0] < tMax [2] ? 0 : 2) : (tMax [1] < tMax [2] ? 1 : 2);
+		if (tMax [axis] > 1.0f)
+		{
+			break;
+		}
+
+		cell [axis] += step [axis];
+		tMax [axis] += tDelta [axis];
+	}
+}
\ No newline at end of file
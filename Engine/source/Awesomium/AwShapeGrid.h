@@ -0,0 +1,61 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Core/Util/TDictionary.h"
+#include "Core/Util/tVector.h"
+#include "math/mPoint3.h"
+
+class AwShape;
+
+/*
+ *  AwShapeGrid
+ *  -----------------------------------------------------------------------------------------------
+ *	Uniform grid over the world boxes of the client side AwShapes. Used by AwManager to find the
+ *	shapes near the camera and the shapes along a picking ray without looking at all of them.
+ *	Cells are hashed, so only cells which contain shapes take memory. Cells far apart can share a
+ *	bucket, which only costs a few extra candidates.
+ */
+class AwShapeGrid
+{
+	typedef Vector <AwShape *> Cell;
+
+	Map <U32, Cell> mCells;									// Shapes by the hash of their cell coordinates.
+	F32 mCellSize;											// Size of a cell in world units.
+	U32 mQueryMark;											// Incremented for every query. Shapes remember the last query which returned them, so shapes spanning several cells are returned once.
+
+	static U32 getKey (S32 x, S32 y, S32 z) { return ((U32)x & 0x3FF) | (((U32)y & 0x3FF) << 10) | (((U32)z & 0x3FF) << 20); }
+	Point3I getCell (const Point3F &pnt) const;
+	void getCellRange (AwShape *shape, Point3I &min, Point3I &max) const;
+	void addToCells (AwShape *shape);
+	void removeFromCells (AwShape *shape);
+	void collectCell (S32 x, S32 y, S32 z, Vector <AwShape *> &result); // Appends the shapes in the cell which weren't returned by the current query yet.
+
+public:
+	AwShapeGrid ();
+
+	void setCellSize (F32 cellSize);						// Sets the size of the cells. Only possible while the grid is empty.
+	void insert (AwShape *shape);
+	void remove (AwShape *shape);
+	void update (AwShape *shape);							// Moves the shape to the cells its world box covers now. Call when it has moved or scaled.
+	void findInRadius (const Point3F &center, F32 radius, Vector <AwShape *> &result); // Appends the shapes whose world box is within the radius.
+	void findAlongRay (const Point3F &start, const Point3F &end, Vector <AwShape *> &result); // Appends the shapes whose cells the ray passes, nearest cells first.
+};
\ No newline at end of file
@@ -90,6 +90,13 @@ void AwStatsGui::onRender (Point2I offset, const RectI &updateRect)
 		else
 		{
 			line += "   |   [FPS: " + String::ToString ("%i", framerate) + "]";
+			line += "   [Dirty: " + String::ToString ("%.0f%%", target->getDirtyAreaRatio () * 100.0f) + "]";
+			line += "   [Deferred: " + String::ToString ("%i KB", target->getDeferredBytes () / 1024) + "]";
+			line += "   [Worst stale: " + String::ToString ("%i ms", target->getWorstStaleness ()) + "]";
+			line += "   [Res: " + String::ToString ("%ix%i", target->getResolution ().x, target->getResolution ().y) + "]";
+			line += "   [Nearest: " + String::ToString ("%.1f", target->getMetrics ().nearestDistance) + "]";
+			line += "   [Coverage: " + String::ToString ("%.1f%%", target->getMetrics ().screenArea / AwManager::getViewportArea () * 100.0f) + "]";
+			line += "   [Visible: " + String::ToString ("%i/%i", target->getMetrics ().numVisibleInstances, target->getNumShapesBound ()) + "]";
 		}
 
 		line += "   (Refs: " + String::ToString ("%i", target->getRefCount ()) + ")";
@@ -0,0 +1,124 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwSurface.h"
+#include "AwManager.h"
+
+AwSurface::AwSurface (int width, int height, AwPixelCopy::CopyMode copyMode)
+{
+	mWidth = width;
+	mHeight = height;
+	mPitch = width * 4;
+	mCopyMode = copyMode;
+	mPaintBlit = AwPixelCopy::getBlitFunc (GFXFormatR8G8B8A8, copyMode);
+	mBuffer = new U8 [mPitch * mHeight];
+	dMemset (mBuffer, 0, mPitch * mHeight);
+
+	// A new surface has never been uploaded, so all of it is dirty.
+	mDirtyRegion.add (RectI (0, 0, width, height));
+}
+
+AwSurface::~AwSurface ()
+{
+	delete [] mBuffer;
+}
+
+void AwSurface::Paint (unsigned char *srcBuffer, int srcRowSpan, const Awesomium::Rect &srcRect, const Awesomium::Rect &destRect)
+{
+	RectI area (destRect.x, destRect.y, destRect.width, destRect.height);
+	if (!area.intersect (RectI (0, 0, mWidth, mHeight)))
+	{
+		return;
+	}
+
+	// Awesomium's buffer is only valid during this call and has to be copied anyway, so convert while copying.
+	const U8 *src = srcBuffer + ((srcRect.y + area.point.y - destRect.y) * srcRowSpan) + ((srcRect.x + area.point.x - destRect.x) * 4);
+	U8 *dst = mBuffer + (area.point.y * mPitch) + (area.point.x * 4);
+	mPaintBlit (dst, mPitch, src, srcRowSpan, area.extent.x, area.extent.y);
+
+	mDirtyRegion.add (area);
+}
+
+void AwSurface::Scroll (int dx, int dy, const Awesomium::Rect &clipRect)
+{
+	RectI clip (clipRect.x, clipRect.y, clipRect.width, clipRect.height);
+	if (!clip.intersect (RectI (0, 0, mWidth, mHeight)))
+	{
+		return;
+	}
+
+	// The part of the clip rect which receives pixels from inside the clip rect.
+	RectI dest (clip.point.x + dx, clip.point.y + dy, clip.extent.x, clip.extent.y);
+	if (dest.intersect (clip))
+	{
+		U32 rowBytes = dest.extent.x * 4;
+		S32 srcX = dest.point.x - dx;
+
+		// Walk the rows in the direction which doesn't overwrite rows we still have to read.
+		for (S32 i = 0; i < dest.extent.y; i++)
+		{
+			S32 y = dy > 0 ? dest.point.y + dest.extent.y - 1 - i : dest.point.y + i;
+			dMemmove (mBuffer + (y * mPitch) + (dest.point.x * 4), mBuffer + ((y - dy) * mPitch) + (srcX * 4), rowBytes);
+		}
+	}
+
+	mDirtyRegion.add (clip);
+}
+
+U8 AwSurface::getAlphaAtPoint (S32 x, S32 y) const
+{
+	if (x < 0 || y < 0 || x >= mWidth || y >= mHeight)
+	{
+		return 255;
+	}
+
+	// Alpha is the fourth byte in both BGRA and RGBA.
+	return mBuffer [(y * mPitch) + (x * 4) + 3];
+}
+
+void AwSurface::setCopyMode (AwPixelCopy::CopyMode copyMode)
+{
+	if (copyMode == mCopyMode)
+	{
+		return;
+	}
+
+	// Both modes differ by an R/B swap, so the pixels painted so far only need to be swapped, and the view doesn't have to repaint.
+	AwPixelCopy::getRowFunc (AwPixelCopy::SwapRB) (mBuffer, mBuffer, mWidth * mHeight);
+	mCopyMode = copyMode;
+	mPaintBlit = AwPixelCopy::getBlitFunc (GFXFormatR8G8B8A8, copyMode);
+	invalidate ();
+}
+
+void AwSurface::takeDirtyRegion (AwDirtyRegion &region)
+{
+	region.add (mDirtyRegion);
+	mDirtyRegion.clear ();
+}
+
+Awesomium::Surface *AwSurfaceFactory::CreateSurface (Awesomium::WebView *view, int width, int height)
+{
+	return new AwSurface (width, height, AwManager::getTextureCopyMode ());
+}
+
+void AwSurfaceFactory::DestroySurface (Awesomium::Surface *surface)
+{
+	delete static_cast <AwSurface *> (surface);
+}
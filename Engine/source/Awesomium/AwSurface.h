@@ -0,0 +1,75 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+// Awesomium headers
+#include <Awesomium/Surface.h>
+
+#include "AwDirtyRegion.h"
+#include "AwPixelCopy.h"
+
+/*
+ *  AwSurface
+ *  -----------------------------------------------------------------------------------------------
+ *	Surface which Awesomium paints into. Paint converts the incoming rectangles straight into a
+ *	persistent buffer in the texture layout, so AwContext only has to copy the changed regions into
+ *	its textures. Remembers the regions which were painted or scrolled since the last update. Only
+ *	touched on the main thread, so painting never waits for anything.
+ */
+class AwSurface : public Awesomium::Surface
+{
+	U8 *mBuffer;											// The pixels, in the texture layout.
+	S32 mWidth;
+	S32 mHeight;
+	U32 mPitch;												// Bytes per row.
+	AwPixelCopy::CopyMode mCopyMode;						// How Awesomium's BGRA is converted to the texture layout.
+	AwPixelCopy::BlitFunc mPaintBlit;						// Converts Awesomium's BGRA to the texture layout.
+	AwDirtyRegion mDirtyRegion;								// Regions changed since the last call to takeDirtyRegion ().
+
+public:
+	AwSurface (int width, int height, AwPixelCopy::CopyMode copyMode);
+	virtual ~AwSurface ();
+
+	virtual void Paint (unsigned char *srcBuffer, int srcRowSpan, const Awesomium::Rect &srcRect, const Awesomium::Rect &destRect);
+	virtual void Scroll (int dx, int dy, const Awesomium::Rect &clipRect);
+
+	const U8 *getBuffer () const { return mBuffer; }
+	U32 getPitch () const { return mPitch; }
+	S32 getWidth () const { return mWidth; }
+	S32 getHeight () const { return mHeight; }
+	U8 getAlphaAtPoint (S32 x, S32 y) const;				// Returns the alpha of the pixel, or 255 if the point is outside the surface.
+
+	void takeDirtyRegion (AwDirtyRegion &region);			// Moves the accumulated dirty regions into region.
+	void invalidate () { mDirtyRegion.add (RectI (0, 0, mWidth, mHeight)); } // Marks the whole surface as dirty.
+	void setCopyMode (AwPixelCopy::CopyMode copyMode);		// Converts the buffer to a new texture layout, like after a device reset picked another format. Does nothing if the mode hasn't changed.
+};
+
+/*
+ *  AwSurfaceFactory
+ *  -----------------------------------------------------------------------------------------------
+ *	Creates AwSurfaces for all views. Registered with the WebCore by AwManager.
+ */
+class AwSurfaceFactory : public Awesomium::SurfaceFactory
+{
+public:
+	virtual Awesomium::Surface *CreateSurface (Awesomium::WebView *view, int width, int height);
+	virtual void DestroySurface (Awesomium::Surface *surface);
+};
@@ -0,0 +1,119 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AwTexturePool.h"
+#include "GFX/GFXTextureManager.h"
+#include "GFX/GFXDevice.h"
+
+Vector <AwTexturePool::Entry> AwTexturePool::sFreeTextures;
+Vector <GFXTexHandle> AwTexturePool::sSharedTextures;
+U32 AwTexturePool::sFreeBytes												= 0;
+U32 AwTexturePool::sMaxFreeBytes											= 32 * 1024 * 1024;
+U32 AwTexturePool::sTimeout													= 5000;
+
+Point2I AwTexturePool::getPaddedSize (const Point2I &size)
+{
+	return Point2I (((size.x + BucketSize - 1) / BucketSize) * BucketSize, ((size.y + BucketSize - 1) / BucketSize) * BucketSize);
+}
+
+GFXTexHandle AwTexturePool::acquire (const Point2I &size, GFXFormat format, bool allowPadding)
+{
+	Point2I textureSize = allowPadding ? getPaddedSize (size) : size;
+
+	// Take the most recently released match, it's the most likely to still be resident.
+	for (S32 i = sFreeTextures.size () - 1; i >= 0; i--)
+	{
+		Entry &entry = sFreeTextures [i];
+		if (entry.size == textureSize && entry.format == format)
+		{
+			GFXTexHandle texture = entry.texture;
+			remove (i);
+			return texture;
+		}
+	}
+
+	return GFX->getTextureManager ()->createTexture (textureSize.x, textureSize.y, format, &GFXDynamicTextureProfile, 0, 0);
+}
+
+void AwTexturePool::release (GFXTexHandle &texture)
+{
+	if (!texture)
+	{
+		return;
+	}
+
+	// Texture targets keep showing the last frame until the resized context has uploaded a new one, so wait for them to let go.
+	if (texture->getRefCount () > 1)
+	{
+		sSharedTextures.push_back (texture);
+		texture = nullptr;
+		return;
+	}
+
+	addFree (texture);
+	trim ();
+}
+
+void AwTexturePool::addFree (GFXTexHandle &texture)
+{
+	Entry entry;
+	entry.texture = texture;
+	entry.size.set (texture->getBitmapWidth (), texture->getBitmapHeight ());
+	entry.format = texture->getFormat ();
+	entry.releaseTime = Platform::getRealMilliseconds ();
+	texture = nullptr;
+
+	// All pooled formats are 32-bit.
+	sFreeBytes += entry.size.x * entry.size.y * 4;
+	sFreeTextures.push_back (entry);
+}
+
+void AwTexturePool::remove (U32 index)
+{
+	Entry &entry = sFreeTextures [index];
+	sFreeBytes -= entry.size.x * entry.size.y * 4;
+	sFreeTextures.erase (index);
+}
+
+void AwTexturePool::trim ()
+{
+	for (S32 i = sSharedTextures.size () - 1; i >= 0; i--)
+	{
+		if (sSharedTextures [i]->getRefCount () == 1)
+		{
+			addFree (sSharedTextures [i]);
+			sSharedTextures.erase (i);
+		}
+	}
+
+	// The oldest textures are at the front.
+	U32 time = Platform::getRealMilliseconds ();
+	while (sFreeTextures.size () && (sFreeBytes > sMaxFreeBytes || sFreeTextures [0].releaseTime + sTimeout < time))
+	{
+		remove (0);
+	}
+}
+
+void AwTexturePool::clear ()
+{
+	sFreeTextures.clear ();
+	sSharedTextures.clear ();
+	sFreeBytes = 0;
+}
\ No newline at end of file
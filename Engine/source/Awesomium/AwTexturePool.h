@@ -0,0 +1,66 @@
+// Copyright (c) 2016 Stefan Lundmark (www.stefanlundmark.com)
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "GFX/GFXTextureHandle.h"
+#include "Core/Util/tVector.h"
+
+/*
+ *  AwTexturePool
+ *  -----------------------------------------------------------------------------------------------
+ *	Keeps the textures released by contexts around for a moment, so resizing a view or changing
+ *	its resolution tier doesn't allocate video memory every time. Shared by all contexts.
+ *	Owners which draw a sub-rect of the texture (like AwGui) can ask for padded textures, which
+ *	are rounded up to the next bucket so a range of sizes can share them.
+ */
+class AwTexturePool
+{
+	friend class AwManager;
+
+	enum
+	{
+		BucketSize = 128									// Padded textures are rounded up to a multiple of this.
+	};
+
+	struct Entry
+	{
+		GFXTexHandle texture;
+		Point2I size;
+		GFXFormat format;
+		U32 releaseTime;									// When the texture was handed back.
+	};
+
+	static Vector <Entry> sFreeTextures;					// Unused textures, oldest first.
+	static Vector <GFXTexHandle> sSharedTextures;			// Released textures which something else still shows. They become free once the pool holds the last reference.
+	static U32 sFreeBytes;									// Memory held by the unused textures.
+	static U32 sMaxFreeBytes;								// The most memory to hold in unused textures.
+	static U32 sTimeout;									// Milliseconds an unused texture is kept.
+
+	static void remove (U32 index);
+	static void addFree (GFXTexHandle &texture);			// Adds a texture nobody else references to the free list.
+
+public:
+	static Point2I getPaddedSize (const Point2I &size);		// Returns the size of the bucket used for padded textures of the given size.
+	static GFXTexHandle acquire (const Point2I &size, GFXFormat format, bool allowPadding); // Returns a texture of the size (or the size of its bucket, if padding is allowed). Reuses a free one when possible.
+	static void release (GFXTexHandle &texture);			// Hands the texture back to the pool and clears the handle. Textures still referenced elsewhere are reused once they're let go.
+	static void trim ();									// Frees textures which have been unused for too long or don't fit in the budget, and picks up shared textures which were let go. Called once per frame.
+	static void clear ();									// Frees all unused textures.
+};
\ No newline at end of file
@@ -24,10 +24,12 @@
 #include "AwManager.h"
 #include "AwContext.h"
 #include "AwShape.h"
+#include "AwCacheLoader.h"
 #include "T3D/GameBase/GameConnection.h"
 #include "SFX/SFXTypes.h"
 #include "gui/3d/guiTSControl.h"
 #include "Core/Stream/FileStream.h"
+#include "core/volume.h"
 
 IMPLEMENT_CONOBJECT (AwTextureTarget);
 
@@ -39,11 +41,21 @@ void AwTextureTarget::initPersistFields ()
 	addField ("TextureTargetName",	TypeRealString,	Offset (mTexTargetName, AwTextureTarget), "Name of the texture target. The texture name can be used in materials to reference this AwTextureTarget.");
 	addField ("Framerate",			TypeS8,			Offset (mFramerate, AwTextureTarget), "The amount of frames per second to render. 0 means unlimited.");
 	addField ("Resolution",			TypePoint2I,	Offset (mResolution, AwTextureTarget), "Resolution. Defaults to (640, 480).");
+	addField ("ResolutionLOD",		TypeBool,		Offset (mUseResolutionLOD, AwTextureTarget), "If set, the page is rendered at half or a quarter of the resolution when all shapes showing it are far away. See $pref::Awesomium::ResolutionLODDistance. Default: Disabled");
 	addField ("CursorBitmap",		TypeRealString,	Offset (mCursorBitmapPath, AwTextureTarget), "The bitmap which is used as a cursor. A default cursor will be used if none is set.");
+	addField ("CursorOverlay",		TypeBool,		Offset (mCursorOverlay, AwTextureTarget), "If set, AwShapes draw the cursor on top of the texture instead of it being composited into the texture. Moving the cursor then costs no uploads. Default: Disabled");
+	addField ("TextureRingDepth",	TypeS8,			Offset (mTextureRingDepth, AwTextureTarget), "The number of textures cycled trough when uploading (1-3). More textures avoid GPU stalls at the cost of memory. Default: 1");
 
 	addField ("IsSingleFrame",	 TypeBool,			Offset (mIsSingleFrame, AwTextureTarget), "Tells this AwTextureTarget to only generate a single frame. This consumes much less resources than a regular AwTextureTarget. Default: Disabled");
 	addField ("UseBitmapCache",	 TypeBool,			Offset (mUseBitmapCache, AwTextureTarget), "If set, enables the bitmap cache. This cache is useful when the webpage is loading and you want the user to see something right away.");
-	addField ("BitmapCachePath", TypeRealString,	Offset (mBitmapCachePath, AwTextureTarget), "Forces the BitmapCache filename instead of letting the system chose a filename automatically.");
+	addField ("BitmapCachePath", TypeRealString,	Offset (mBitmapCachePath, AwTextureTarget), "Forces the BitmapCache filename instead of letting the system chose a filename automatically. Forced files are never invalidated or evicted.");
+	addField ("CacheVersion",	 TypeRealString,	Offset (mCacheVersion, AwTextureTarget), "Part of the bitmap cache key. Change it when the page's content changes in a way the URL doesn't show.");
+	addField ("IsTransparent",	 TypeBool,			Offset (mIsTransparent, AwTextureTarget), "Whether the page is rendered with transparency or not. Default: Disabled");
+	addField ("CompressedTexture", TypeBool,		Offset (mCompressedTexture, AwTextureTarget), "If set, single-frame targets and targets rendering at 1 fps or less are shown with a DXT1/DXT5 compressed texture, which takes a fraction of the video memory. Default: Disabled");
+
+	addField ("SaveStateScript",		TypeRealString,	Offset (mSaveStateScript, AwTextureTarget), "JavaScript which returns the state of the page as a string, like the last statement of a script does. It's run before the view is destroyed to save memory, without waiting for the page. "
+		"If it throws, the view is destroyed without a state after a second. See $pref::Awesomium::HibernateTime.");
+	addField ("RestoreStateFunction",	TypeRealString,	Offset (mRestoreStateFunction, AwTextureTarget), "Name of a JavaScript function which is called with the string returned by SaveStateScript, once the page has been reloaded.");
 
 	addField ("OnGainMouseInputSound", TypeSFXTrackName,  Offset (mOnGainMouseInputSound, AwTextureTarget), "The sound profile to play when gaining mouse input.");
 	addField ("OnLoseMouseInputSound", TypeSFXTrackName,  Offset (mOnLoseMouseInputSound, AwTextureTarget), "The sound profile to play when losing mouse input.");
@@ -53,18 +65,40 @@ void AwTextureTarget::initPersistFields ()
 AwTextureTarget::AwTextureTarget ()
 {
 	mResolution.set (640, 480);
+	mUseResolutionLOD = false;
+	mResolutionLOD = 0;
+	mLastResolutionLODChange = 0;
+	mHasDistance = false;
+	mPriority = 0.0f;
+	mUpdateCost = 0.0f;
+	mLastUpdateTime = 0;
+	mReadySinceTime = 0;
+	mDeferredBytes = 0;
+	mWorstStaleness = 0;
 	mFramerate = 0;
 	mActualFramerate = 0;
+	mTextureRingDepth = 1;
+	mCursorOverlay = false;
 	mOnGainMouseInputSound = nullptr;
 	mOnLoseMouseInputSound = nullptr;
 	mLastRenderTime = 0;
-	mLargestDistanceThisUpdate = 0;
+	mLastVisibleFrame = 0;
+	mVisibleSinceTime = 0;
+	mInvisibleSinceTime = 0;
+	mSaveStateTime = 0;
+	mIsHibernating = false;
 	mNumShapesBound = 0;
 	mRefCount = 0;
+	mDenseIndex = AwDenseList <AwTextureTarget>::InvalidIndex;
 	mIsSingleFrame = false;
 	mHasWrittenToCache = false;
 	mUseBitmapCache = false;
+	mIsCacheManaged = false;
+	mIsTransparent = false;
 	mIsShowingCachedBitmap = false;
+	mCompressedTexture = false;
+	mIsShowingCompressedTexture = false;
+	mCompressedFrameNumber = 0;
 }
 
 bool AwTextureTarget::onAdd ()
@@ -94,18 +128,11 @@ bool AwTextureTarget::onAdd ()
 		return false;
 	}
 
-	// Automatically generate the bitmap cache filename.
-	if (mUseBitmapCache && mBitmapCachePath.isEmpty ())
+	if (mUseBitmapCache)
 	{
-		mBitmapCachePath = String ("./") + String (getName ());
+		updateCachePaths ();
 	}
 
-	char temp [2048]; 
-	Con::expandScriptFilename (&temp [0], sizeof (temp), mBitmapCachePath.c_str ());
-	Torque::Path path = temp;
-	path.setExtension ("png");
-	mBitmapCachePath = path;
-
 	mTexTarget.getTextureDelegate ().bind (this, &AwTextureTarget::onRender);
 	AwManager::addTextureTarget (this);
 
@@ -122,6 +149,8 @@ void AwTextureTarget::onRemove ()
 		sMouseInputTarget = nullptr;
 	}
 
+	cancelCompression ();
+	mCacheLoadJob = nullptr;
 	delete mContext;
 	mContext = nullptr;
 	AwManager::removeTextureTarget (this);
@@ -130,33 +159,61 @@ void AwTextureTarget::onRemove ()
 
 GFXTexHandle AwTextureTarget::getTexture () 
 {
-	if (mTexture && !mHasWrittenToCache && mUseBitmapCache && mContext && !mContext->isLoading ())
+	// Only full resolution snapshots go into the cache, as that's what its key says.
+	if (mTexture && !mHasWrittenToCache && mUseBitmapCache && mContext && !mContext->isLoading () && mContext->getResolution () == mResolution)
 	{
-		mHasWrittenToCache = true;
-		FileStream stream;
-		if (!Platform::isFile (mBitmapCachePath) && stream.open (mBitmapCachePath, Torque::FS::File::Write))
-		{
-			GBitmap bmp (mTexture->getBitmapWidth (), mTexture->getBitmapHeight (), false, GFXFormatR8G8B8A8);
-			if (mTexture->copyToBmp (&bmp))
-			{
-				bmp.writeBitmap ("png", stream);
-				stream.close ();
-			}
-		}
+		// The copy fails while the view is still being resized, so try again next time.
+		mHasWrittenToCache = queueCacheWrite (mContext);
 	}
 
+	finishCompression (false);
+
 	if (mIsSingleFrame)
 	{
 		if (mContext && !mContext->isLoading ())
 		{
 			mTexture = mContext->getTexture ();
+			if (mCompressedTexture)
+			{
+				// The uncompressed texture is shown until the compressed one is ready.
+				beginCompression ();
+			}
+
 			delete mContext;
 			mContext = nullptr;
 		}
 	}
-	else if (mContext && (!mUseBitmapCache || (!mContext->isLoading () || !mIsShowingCachedBitmap)))
+	else if (mContext && (!mContext->isLoading () || !mIsShowingCachedBitmap))
 	{
-		mTexture = mContext->getTexture ();
+		if (wantsCompressedTexture ())
+		{
+			// Release the context's textures the first time around, and recompress whenever the page has changed.
+			// The last uncompressed texture is shown until the compressed one is ready.
+			if (!mIsShowingCompressedTexture)
+			{
+				mTexture = mContext->getCurrentTexture ();
+				mContext->setTexturesEnabled (false);
+				mIsShowingCompressedTexture = true;
+				beginCompression ();
+			}
+
+			if (!mCompressionJob && mContext->getFrameNumber () != mCompressedFrameNumber)
+			{
+				beginCompression ();
+			}
+		}
+		else
+		{
+			if (mIsShowingCompressedTexture)
+			{
+				cancelCompression ();
+				mContext->setTexturesEnabled (true);
+			}
+
+			// AwManager schedules the updates, so just show the most recent texture.
+			mTexture = mContext->getCurrentTexture ();
+		}
+
 		// We only want to overwrite the cached texture with a texture from the context if the context has finished loading.
 		mIsShowingCachedBitmap = false; 
 	}
@@ -164,6 +221,113 @@ GFXTexHandle AwTextureTarget::getTexture ()
 	return mTexture;
 }
 
+bool AwTextureTarget::queueCacheWrite (AwContext *context)
+{
+	// This runs inside the render delegate, so only the copy happens here. Encoding and writing happen on a worker.
+	AwBitmapCache::Format format = (AwBitmapCache::Format)AwManager::getBitmapCacheFormat ();
+	GBitmap *bmp = new GBitmap (context->getResolution ().x, context->getResolution ().y, false, GFXFormatR8G8B8A8);
+	if (!context->copyToBitmap (bmp))
+	{
+		delete bmp;
+		return false;
+	}
+
+	mCacheWriteJob = new AwCacheWriteJob (bmp, format == AwBitmapCache::FormatPNG ? mBitmapCachePath : mRawCachePath, format, mIsCacheManaged);
+	mCacheWriteJob->queue ();
+	return true;
+}
+
+bool AwTextureTarget::hasCacheFile ()
+{
+	return Torque::FS::IsFile (mRawCachePath) || Torque::FS::IsFile (mBitmapCachePath);
+}
+
+AwContext *AwTextureTarget::createPrerenderContext ()
+{
+	// No textures and no cursor, only the pixels are needed.
+	AwContext *context = new AwContext;
+	context->setTransparent (mIsTransparent);
+	context->setTexturesEnabled (false);
+	context->setResolution (mResolution, true);
+	context->loadURL (mStartURL);
+	return context;
+}
+
+bool AwTextureTarget::wantsCompressedTexture ()
+{
+	if (!mCompressedTexture || sMouseInputTarget == this || !mContext || mContext->isLoading ())
+	{
+		return false;
+	}
+
+	// Pausing doesn't count. A paused target is only drawn while it comes back into view, and would throw the compressed texture away again a
+	// few frames later. The actual framerate is only worked out while the target is in view, so go by the configured one if there is one.
+	U32 framerate = mFramerate > 0 ? mFramerate : mActualFramerate;
+	return framerate > 0 && framerate <= 1;
+}
+
+void AwTextureTarget::beginCompression ()
+{
+	if (mCompressionJob)
+	{
+		return;
+	}
+
+	// Copy the pixels on the CPU, so the context is free to carry on or be deleted.
+	Point2I resolution = mContext->getResolution ();
+	GBitmap *bmp = new GBitmap (resolution.x, resolution.y, false, GFXFormatR8G8B8A8);
+	if (!mContext->copyToBitmap (bmp))
+	{
+		delete bmp;
+		return;
+	}
+
+	mCompressedFrameNumber = mContext->getFrameNumber ();
+	mCompressionJob = new AwCompressionJob (bmp);
+	mCompressionJob->queue ();
+}
+
+void AwTextureTarget::finishCompression (bool wait)
+{
+	if (!mCompressionJob)
+	{
+		return;
+	}
+
+	if (wait)
+	{
+		mCompressionJob->wait ();
+	}
+	else if (!mCompressionJob->isDone ())
+	{
+		return;
+	}
+
+	DDSFile *dds = mCompressionJob->takeResult ();
+	mCompressionJob = nullptr;
+
+	// The target may have stopped wanting the compressed texture while the job was running.
+	if (dds && (mIsSingleFrame || mIsShowingCompressedTexture))
+	{
+		mTexture.set (dds, &GFXDefaultStaticDiffuseProfile, true, "AwTextureTarget compressed");
+	}
+	else
+	{
+		delete dds;
+	}
+}
+
+void AwTextureTarget::cancelCompression ()
+{
+	if (mCompressionJob)
+	{
+		mCompressionJob->wait ();
+		mCompressionJob = nullptr;
+	}
+
+	mIsShowingCompressedTexture = false;
+}
+
 void AwTextureTarget::incrRef ()
 {
 	mRefCount++;
@@ -175,6 +339,10 @@ void AwTextureTarget::decrRef ()
 	mRefCount--;
 	if (mRefCount == 0)
 	{
+		mIsHibernating = false;
+		mHibernatedScripts.clear ();
+		cancelCompression ();
+		mCacheLoadJob = nullptr;
 		delete mContext;
 		mContext = nullptr;
 		mTexture = nullptr;
@@ -183,27 +351,111 @@ void AwTextureTarget::decrRef ()
 
 void AwTextureTarget::initContext ()
 {
-	if (mContext || mTexture)
+	if (mContext || mTexture || mCacheLoadJob)
 	{
 		return;
 	}
 
 	if (mUseBitmapCache)
 	{
-		mTexture.set (mBitmapCachePath, &GFXDefaultStaticDiffuseProfile, "");
+		// Shapes register while the mission loads, so the file is decoded on a worker together with the others and uploaded by AwCacheLoader.
+		mCacheLoadJob = AwCacheLoader::queue (this, mRawCachePath, mBitmapCachePath);
 		mIsShowingCachedBitmap = true;
+
+		// A single frame from a content keyed cache file (see awPrerenderCache) is exactly what the view would produce, so don't start one.
+		// If the file turns out to be unusable, finishCacheLoad () starts it after all.
+		if (mIsSingleFrame && mIsCacheManaged && hasCacheFile ())
+		{
+			mHasWrittenToCache = true;
+			return;
+		}
 	}
 
+	createContext (mStartURL);
+}
+
+bool AwTextureTarget::finishCacheLoad (AwCacheLoadJob *job)
+{
+	// The load was dropped when the last reference went away.
+	if (job != mCacheLoadJob)
+	{
+		return false;
+	}
+	mCacheLoadJob = nullptr;
+
+	GFXTexHandle texture;
+	bool isLoaded = job->upload (texture);
+	if (isLoaded && mIsShowingCachedBitmap && !mTexture)
+	{
+		mTexture = texture;
+	}
+	else if (!isLoaded && !mContext && !mTexture)
+	{
+		mHasWrittenToCache = false;
+		createContext (mStartURL);
+	}
+
+	return isLoaded;
+}
+
+void AwTextureTarget::updateCachePaths ()
+{
+	// A forced filename is used as is, and it's up to the user to delete it when the page changes.
+	if (mBitmapCachePath.isNotEmpty () && !mIsCacheManaged)
+	{
+		char temp [2048]; 
+		Con::expandScriptFilename (&temp [0], sizeof (temp), mBitmapCachePath.c_str ());
+		Torque::Path path = temp;
+		path.setExtension ("png");
+		mBitmapCachePath = path;
+		path.setExtension ("awc");
+		mRawCachePath = path;
+		return;
+	}
+
+	// Pages loaded from the game's files change with them, so their modification time goes into the key as well.
+	String version = mCacheVersion;
+	String assetPath = mStartURL;
+	assetPath.replace ("asset://torque/", "");
+	assetPath.replace ("file:///", "");
+	assetPath.replace ("file://", "");
+	if (assetPath.find ("://") == String::NPos && assetPath.find ("www.") != 0)
+	{
+		String::SizeType end = assetPath.find ('?');
+		if (end != String::NPos)
+		{
+			assetPath = assetPath.substr (0, end);
+		}
+
+		Torque::FS::FileNodeRef node = Torque::FS::GetFileNode (assetPath);
+		if (node)
+		{
+			version += String::ToString ("|%u", (U32)(node->getModifiedTime ().getMicroseconds () / 1000000));
+		}
+	}
+
+	String key = AwBitmapCache::makeKey (mStartURL, mResolution, mIsTransparent, version);
+	mBitmapCachePath = AwBitmapCache::getPath (key, AwBitmapCache::FormatPNG);
+	mRawCachePath = AwBitmapCache::getPath (key, AwBitmapCache::FormatRaw);
+	mIsCacheManaged = true;
+}
+
+void AwTextureTarget::createContext (const String &url)
+{
 	mContext = new AwContext;
 	mContext->setFramerate (mFramerate);
-	mContext->setResolution (mResolution);
-	mContext->loadURL (mStartURL);
+	mContext->setTransparent (mIsTransparent);
+	mContext->setTextureRingDepth (mTextureRingDepth);
+	mContext->setResolution (getResolution ());
+	mContext->loadURL (url);
 	mContext->setCursorBitmapPath (mCursorBitmapPath);
+	mContext->setCursorOverlay (mCursorOverlay);
 }
 
 GFXTextureObject *AwTextureTarget::onRender (U32 index)
 {
 	mLastRenderTime = Platform::getRealMilliseconds ();
+	markVisible ();
 	return getTexture ();
 }
 
@@ -235,6 +487,8 @@ void AwTextureTarget::onGainMouseInput ()
 {
 	if (mContext)
 	{
+		// Go back to full resolution right away, before any mouse coordinates are mapped.
+		updateResolutionLOD ();
 		mContext->showCursor ();
 	}
 }
@@ -266,8 +520,55 @@ void AwTextureTarget::setMouseInputTarget (AwTextureTarget *target)
 	}
 }
 
+void AwTextureTarget::hibernate ()
+{
+	// Keep showing the last frame. The pool won't recycle the texture while we hold it.
+	GFXTexHandle texture = mIsShowingCompressedTexture ? mTexture : mContext->getCurrentTexture ();
+	cancelCompression ();
+
+	mHibernatedURL = mContext->getViewURL ();
+	mHibernatedState = mSaveStateTime != 0 && !mContext->isSavingState () ? mContext->getSavedState () : String ();
+
+	delete mContext;
+	mContext = nullptr;
+	mTexture = texture;
+	mIsHibernating = true;
+	mInvisibleSinceTime = 0;
+	mSaveStateTime = 0;
+}
+
+void AwTextureTarget::wake ()
+{
+	mIsHibernating = false;
+	createContext (mHibernatedURL);
+
+	// Show the last frame until the page has been reloaded.
+	mIsShowingCachedBitmap = !mTexture.isNull ();
+
+	if (mRestoreStateFunction.isNotEmpty () && mHibernatedState.isNotEmpty ())
+	{
+		// Pass the state as a string literal.
+		mContext->execJavaScriptWhenReady (mRestoreStateFunction + "(" + AwContext::quoteJavaScriptString (mHibernatedState) + ");");
+	}
+
+	// Scripts sent while the view was gone run after the state has been restored, in the order they were sent.
+	for (U32 i = 0; i < mHibernatedScripts.size (); i++)
+	{
+		mContext->execJavaScriptWhenReady (mHibernatedScripts [i]);
+	}
+
+	mHibernatedURL = String ();
+	mHibernatedState = String ();
+	mHibernatedScripts.clear ();
+}
+
 bool AwTextureTarget::isPaused ()
 {
+	if (mIsHibernating)
+	{
+		return true;
+	}
+
 	if (mContext)
 	{
 		return mContext->isPaused ();
@@ -275,7 +576,7 @@ bool AwTextureTarget::isPaused ()
 
 	if (mIsSingleFrame)
 	{
-		return mLastRenderTime + 500 < Platform::getRealMilliseconds ();
+		return !isVisible ();
 	}
 
 	return false;
@@ -283,24 +584,68 @@ bool AwTextureTarget::isPaused ()
 
 void AwTextureTarget::update (U32 fps)
 {
+	mPriority = 0.0f;
+	mDeferredBytes = 0;
+	if (mIsHibernating && (isVisible () || sMouseInputTarget == this))
+	{
+		wake ();
+	}
+
 	if (!mContext || mIsSingleFrame)
 	{
 		return;
 	}
 
-	// If the target hasn't been used for a moment, pause the context. Do not let it pause if we're currently focused.
-	// TODO: Make the time value configurable?
-	if ((mLastRenderTime == 0 || mLastRenderTime + 500 < Platform::getRealMilliseconds ()) && sMouseInputTarget != this)
+	// If nothing showing the target was drawn last frame, pause the context right away. Do not let it pause if we're currently focused.
+	U32 time = Platform::getRealMilliseconds ();
+	if (!isVisible () && sMouseInputTarget != this)
 	{
+		if (mInvisibleSinceTime == 0)
+		{
+			mInvisibleSinceTime = time;
+		}
+		mVisibleSinceTime = 0;
 		mContext->pause ();
+
+		// After a long while, get rid of the view as well. The page's state is asked for first, and the view is destroyed once it has been
+		// posted back. Waiting for it on the spot would stall the frame for as long as the page takes.
+		if (AwManager::getHibernateTime () > 0 && mInvisibleSinceTime + AwManager::getHibernateTime () <= time && !mContext->isLoading ())
+		{
+			if (mSaveStateScript.isNotEmpty () && mSaveStateTime == 0)
+			{
+				mSaveStateTime = time;
+				mContext->requestState (mSaveStateScript);
+			}
+
+			// A page which throws never answers, so give up on its state after a while.
+			if (mSaveStateScript.isEmpty () || !mContext->isSavingState () || mSaveStateTime + SaveStateTimeout <= time)
+			{
+				hibernate ();
+			}
+		}
 		return;
 	}
 
+	mInvisibleSinceTime = 0;
+	mSaveStateTime = 0;
+	if (mVisibleSinceTime == 0)
+	{
+		mVisibleSinceTime = time;
+	}
+
 	if (mContext->isPaused ())
 	{
+		// Only resume once the target has stayed in view for a moment, so sweeping the camera past a screen doesn't wake it up.
+		if (sMouseInputTarget != this && mVisibleSinceTime + AwManager::getResumeHysteresis () > time)
+		{
+			return;
+		}
+
 		mContext->resume ();
 	}
 
+	updateResolutionLOD ();
+
 	if (sMouseInputTarget == this)
 	{
 		mActualFramerate = 0;
@@ -309,14 +654,9 @@ void AwTextureTarget::update (U32 fps)
 	{
 		if (mFramerate == 0)
 		{
+			// Never round down to 0, as that means unlimited.
 			F32 targetFramerate = fps;
-			if (mLargestDistanceThisUpdate >= AwManager::getLoadBalancingDistance ())
-				mActualFramerate = 1;
-			else
-			{
-				F32 framerate = 1.0f - (mLargestDistanceThisUpdate / AwManager::getLoadBalancingDistance ());
-				mActualFramerate = framerate * targetFramerate;
-			}
+			mActualFramerate = getMax (getDetail () * targetFramerate, 1.0f);
 		}
 		else
 		{
@@ -324,8 +664,194 @@ void AwTextureTarget::update (U32 fps)
 		}
 	}
 	
-	mLargestDistanceThisUpdate = 0;
 	mContext->setFramerate (mActualFramerate);
+
+	// Nothing to do until the context is due for a new frame, or one is ready to upload.
+	if (!mContext->isUpdateReady () && !mContext->isUpdateDue ())
+	{
+		return;
+	}
+
+	// How many frame intervals have passed since the texture was last refreshed. 1 means just in time.
+	F32 interval = 1000.0f / (F32)getMax ((U32)mActualFramerate > 0 ? (U32)mActualFramerate : fps, 1U);
+	F32 staleness = getMax ((F32)(time - mLastUpdateTime) / interval, 1.0f);
+
+	// Stale, important and visible targets come first. Targets seen on several shapes at once matter a bit more. The focused target always comes first.
+	mPriority = staleness * (0.1f + getDetail ());
+	if (mLastVisibleFrame == AwManager::getFrameNumber () - 1)
+	{
+		mPriority *= 2.0f + (0.25f * getMin (getMax (mMetrics.numVisibleInstances, 1U) - 1, 4U));
+	}
+	if (sMouseInputTarget == this)
+	{
+		mPriority += 1000000.0f;
+	}
+}
+
+void AwTextureTarget::runUpdate ()
+{
+	// Upload the frame which is ready, then collect the next one so its cursor is composited while we render.
+	if (mContext->isUpdateReady ())
+	{
+		mContext->finishUpdate ();
+		mLastUpdateTime = Platform::getRealMilliseconds ();
+
+		if (mReadySinceTime != 0)
+		{
+			mWorstStaleness = getMax (mWorstStaleness, mLastUpdateTime - mReadySinceTime);
+			mReadySinceTime = 0;
+		}
+	}
+
+	mContext->beginUpdate ();
+}
+
+U32 AwTextureTarget::getPendingUploadBytes ()
+{
+	return mContext ? mContext->getPendingUploadBytes () : 0;
+}
+
+void AwTextureTarget::deferUpdate (U32 bytes)
+{
+	// The estimate is only measured again when the target runs. Let a single slow update (like the first full upload) wear off.
+	mUpdateCost *= 0.9f;
+	mDeferredBytes += bytes;
+	if (mReadySinceTime == 0 && mContext->isUpdateReady ())
+	{
+		mReadySinceTime = Platform::getRealMilliseconds ();
+	}
+}
+
+void AwTextureTarget::reportDistance (F32 distance)
+{
+	if (mMetricsThisFrame.numReports == 0 || distance < mMetricsThisFrame.nearestDistance)
+	{
+		mMetricsThisFrame.nearestDistance = distance;
+	}
+
+	mMetricsThisFrame.numReports++;
+}
+
+void AwTextureTarget::reportVisibleInstance (F32 screenArea)
+{
+	mMetricsThisFrame.screenArea += screenArea;
+	mMetricsThisFrame.numVisibleInstances++;
+}
+
+void AwTextureTarget::latchMetrics ()
+{
+	if (mMetricsThisFrame.numReports > 0)
+	{
+		mHasDistance = true;
+	}
+	else if (sMouseInputTarget == this)
+	{
+		// The focused target's shapes don't report their distance, so it keeps its last one.
+		mMetricsThisFrame.nearestDistance = mMetrics.nearestDistance;
+	}
+	else if (mNumShapesBound > 0)
+	{
+		// Only shapes near the camera report in, so all of ours are at least this far away.
+		mMetricsThisFrame.nearestDistance = AwManager::getShapeQueryRadius ();
+		mHasDistance = true;
+	}
+	else
+	{
+		mHasDistance = false;
+	}
+
+	mMetrics = mMetricsThisFrame;
+	mMetricsThisFrame.clear ();
+}
+
+F32 AwTextureTarget::getDetail ()
+{
+	if (AwManager::getLoadBalancingMode () == AwManager::LoadBalanceCoverage)
+	{
+		// A target covering FullRateCoverage of the screen or more gets the full framerate.
+		F32 coverage = mMetrics.screenArea / AwManager::getViewportArea ();
+		return mClampF (coverage / AwManager::getFullRateCoverage (), 0.0f, 1.0f);
+	}
+
+	if (AwManager::getLoadBalancingDistance () <= 0.0f)
+	{
+		return 1.0f;
+	}
+
+	return 1.0f - mClampF (mMetrics.nearestDistance / AwManager::getLoadBalancingDistance (), 0.0f, 1.0f);
+}
+
+void AwTextureTarget::updateResolutionLOD ()
+{
+	enum
+	{
+		MaxResolutionLOD = 2,							// A quarter of the full resolution.
+		MinResolutionLODTime = 1000						// Milliseconds a tier is kept before dropping to a lower resolution again.
+	};
+
+	U8 lod = mResolutionLOD;
+	bool isCoverageMode = AwManager::getLoadBalancingMode () == AwManager::LoadBalanceCoverage;
+	F32 tierDistance = AwManager::getResolutionLODDistance ();
+	if (!mUseResolutionLOD || mIsSingleFrame || sMouseInputTarget == this || (!isCoverageMode && tierDistance <= 0.0f))
+	{
+		lod = 0;
+	}
+	else if (mHasDistance)
+	{
+		F32 tiers;
+		if (isCoverageMode)
+		{
+			// Each tier has a quarter of the pixels. Drop a tier once the lower resolution still has as many pixels as the screen area.
+			F32 pixelRatio = (F32)(mResolution.x * mResolution.y) / getMax (mMetrics.screenArea, 1.0f);
+			tiers = mLog (getMax (pixelRatio, 1.0f)) / mLog (4.0f);
+		}
+		else
+		{
+			tiers = mMetrics.nearestDistance / tierDistance;
+		}
+
+		// The value has to pass a tier border by a margin before the tier changes, so targets near a border don't flip back and forth.
+		F32 hysteresis = AwManager::getResolutionLODHysteresis ();
+		while (lod < MaxResolutionLOD && tiers >= (lod + 1) * (1.0f + hysteresis))
+		{
+			lod++;
+		}
+		while (lod > 0 && tiers < lod * (1.0f - hysteresis))
+		{
+			lod--;
+		}
+	}
+
+	if (lod == mResolutionLOD)
+	{
+		return;
+	}
+
+	// Increasing the resolution is never delayed, as the target is getting closer.
+	U32 time = Platform::getRealMilliseconds ();
+	if (lod > mResolutionLOD && mLastResolutionLODChange + MinResolutionLODTime > time)
+	{
+		return;
+	}
+
+	mResolutionLOD = lod;
+	mLastResolutionLODChange = time;
+	mContext->setResolution (getResolution (), true);
+}
+
+Point2I AwTextureTarget::getResolution ()
+{
+	return Point2I (getMax (mResolution.x >> mResolutionLOD, 1), getMax (mResolution.y >> mResolutionLOD, 1));
+}
+
+GFXTexHandle AwTextureTarget::getCursorTexture ()
+{
+	return mContext ? mContext->getCursorTexture () : GFXTexHandle ();
+}
+
+F32 AwTextureTarget::getDirtyAreaRatio ()
+{
+	return mContext ? mContext->getDirtyAreaRatio () : 0.0f;
 }
 
 void AwTextureTarget::execJavaScript (const String &script)
@@ -334,6 +860,10 @@ void AwTextureTarget::execJavaScript (const String &script)
 	{
 		mContext->execJavaScript (script);
 	}
+	else if (mIsHibernating)
+	{
+		mHibernatedScripts.push_back (script);
+	}
 }
 
 void AwTextureTarget::reload ()
@@ -344,6 +874,9 @@ void AwTextureTarget::reload ()
 	}
 	else
 	{
+		cancelCompression ();
+		mIsHibernating = false;
+		mHibernatedScripts.clear ();
 		mTexture = nullptr;
 		initContext ();
 	}
@@ -357,4 +890,24 @@ DefineEngineMethod (AwTextureTarget, execJavaScript, void, (const char *script),
 DefineEngineMethod (AwTextureTarget, reload, void, (),, "")
 {
 	object->reload ();
+}
+
+DefineEngineMethod (AwTextureTarget, getDeferredBytes, S32, (),, "@brief Returns the bytes of uploads deferred this frame because the upload budget was used up.")
+{
+	return object->getDeferredBytes ();
+}
+
+DefineEngineMethod (AwTextureTarget, getWorstStaleness, S32, (),, "@brief Returns the longest a ready frame has waited for its upload, in milliseconds.")
+{
+	return object->getWorstStaleness ();
+}
+
+DefineEngineMethod (AwTextureTarget, resetWorstStaleness, void, (),, "@brief Resets the value returned by getWorstStaleness ().")
+{
+	object->resetWorstStaleness ();
+}
+
+DefineEngineMethod (AwTextureTarget, getDirtyAreaRatio, F32, (),, "@brief Returns the fraction (0-1) of the texture which was uploaded by the most recent copy.")
+{
+	return object->getDirtyAreaRatio ();
 }
\ No newline at end of file
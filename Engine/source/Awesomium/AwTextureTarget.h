@@ -25,10 +25,32 @@
 #include "Console/SimObject.h"
 #include "SFX/SFXTrack.h"
 #include "SFX/SFXSource.h"
+#include "AwCompressionJob.h"
+#include "AwCacheWriteJob.h"
+#include "AwCacheLoadJob.h"
+#include "AwManager.h"
+#include "AwDenseList.h"
 
 class AwContext;
 class AwShape;
 
+/*
+ *  AwTargetMetrics
+ *  -----------------------------------------------------------------------------------------------
+ *	How the shapes showing a target are seen, summed up over all of them. A target shared by a
+ *	shape close by and one far away is treated as close.
+ */
+struct AwTargetMetrics
+{
+	F32 nearestDistance;								// Distance to the closest shape which reported in.
+	F32 screenArea;										// Pixels covered by all shapes together.
+	U32 numVisibleInstances;							// Shapes which survived culling.
+	U32 numReports;										// Shapes which reported their distance.
+
+	AwTargetMetrics () { clear (); }
+	void clear () { nearestDistance = 0.0f; screenArea = 0.0f; numVisibleInstances = 0; numReports = 0; }
+};
+
 /*
  *  AwTextureTarget
  *  -----------------------------------------------------------------------------------------------
@@ -40,25 +62,66 @@ class AwTextureTarget : public SimObject
 	typedef SimObject Parent;
 
 	friend class AwManager;
+	friend class AwDenseList <AwTextureTarget>;
 	friend class AwTextureCursor;
 
 	U32 mRefCount;										// How many references this AwTextureTarget has. When this reaches zero, the target is freed.
+	U32 mDenseIndex;									// Position in AwManager's list of targets.
 	AwContext *mContext;								// The associated context.
-	Point2I mResolution;								// The current resolution. Defaults to (640, 480).
+	Point2I mResolution;								// The full resolution. Defaults to (640, 480).
+	bool mUseResolutionLOD;								// If set, the page is rendered at a lower resolution when all shapes showing it are far away. Defaults to disabled.
+	U8 mResolutionLOD;									// The current resolution tier. 0 is full resolution, each tier halves it.
+	U32 mLastResolutionLODChange;						// When the tier last changed. Used to keep targets from resizing over and over.
 	U8 mFramerate;										// The amount of frames per second to render. 0 means unlimited.
 	U8 mActualFramerate;								// The actual framerate which is calculated based on how distance, mouse focus and other parameters.
+	U8 mTextureRingDepth;								// The number of textures cycled trough when uploading (1-3). More textures avoid GPU stalls at the cost of memory. Defaults to 1.
 	String mStartURL;									// The URL which is loaded initially.
 	String mTexTargetName;								// Name of the texture target. The texture name can be used in materials to reference this AwTextureTarget.
 	String mCursorBitmapPath;							// The bitmap which is used as a cursor. A default cursor will be used if none is set.
+	bool mCursorOverlay;								// If set, AwShapes draw the cursor on top of the texture instead of it being composited into the texture. Moving the cursor then costs no uploads. Defaults to disabled.
 	U32 mLastRenderTime;
-	F32 mLargestDistanceThisUpdate;
+	U32 mLastVisibleFrame;								// The last frame (see AwManager::getFrameNumber) a shape or material showing this target survived culling.
+	U32 mVisibleSinceTime;								// When the target last became visible. 0 while it's invisible.
+	U32 mInvisibleSinceTime;							// When the target last became invisible. 0 while it's visible.
+	bool mIsHibernating;								// Set while the view is destroyed and the last texture is shown in its place.
+	String mHibernatedURL;								// The URL the view was showing when it was destroyed.
+	String mHibernatedState;							// The result of SaveStateScript when the view was destroyed.
+	Vector <String> mHibernatedScripts;					// Scripts executed while the view was destroyed. Run once it's recreated.
+	String mSaveStateScript;							// JavaScript which returns the page's state as a string. Run before hibernating.
+	String mRestoreStateFunction;						// JavaScript function which is called with the saved state once the page has been reloaded.
+	U32 mSaveStateTime;									// When the page was asked to post its state back before hibernating. 0 if it hasn't been.
+
+	enum
+	{
+		SaveStateTimeout = 1000							// Milliseconds to wait for the page's state before hibernating without it.
+	};
+
+	AwTargetMetrics mMetricsThisFrame;					// Collected from the shapes during the current frame.
+	AwTargetMetrics mMetrics;							// Taken over from mMetricsThisFrame once per frame. Used by load balancing and the scheduler.
+	bool mHasDistance;									// Set if mMetrics.nearestDistance is known, from a report or because no shape is near the camera.
+	F32 mPriority;										// How urgently the target wants an update this frame. 0 if it doesn't need one.
+	F32 mUpdateCost;									// Running average of the milliseconds runUpdate () takes. Used by the scheduler to stay inside the frame budget.
+	U32 mLastUpdateTime;								// When the texture was last refreshed.
+	U32 mReadySinceTime;								// When a ready frame was first deferred. 0 if nothing is waiting.
+	U32 mDeferredBytes;									// Bytes of uploads deferred this frame because the budget was used up.
+	U32 mWorstStaleness;								// The longest a ready frame has waited for its upload, in milliseconds.
 	U32 mNumShapesBound;
 	bool mIsSingleFrame;								// Tells this AwTextureTarget to only generate a single frame. This consumes much less resources than a regular AwTextureTarget. Defaults to disabled.
 	String mBitmapCachePath;							// Forces the BitmapCache filename instead of letting the system chose a filename automatically.
+	String mRawCachePath;								// mBitmapCachePath with the .awc extension.
+	String mCacheVersion;								// Part of the bitmap cache key. Changed by the user when the page's content changes in a way the URL doesn't show.
+	bool mIsCacheManaged;								// Set if the cache paths are keyed by content and tracked by AwBitmapCache's manifest, instead of forced by BitmapCachePath.
+	bool mIsTransparent;								// Whether the page is rendered with transparency. Defaults to disabled.
 	GFXTexHandle mTexture;
 	bool mHasWrittenToCache;
 	bool mUseBitmapCache;								// If set, enables the bitmap cache. This cache is useful when the webpage is loading and you want the user to see something right away.
 	bool mIsShowingCachedBitmap;
+	bool mCompressedTexture;							// If set, single-frame targets and targets rendering at 1 fps or less are shown with a block-compressed texture. Defaults to disabled.
+	bool mIsShowingCompressedTexture;					// Set while the context's textures are released in favour of a compressed copy.
+	U32 mCompressedFrameNumber;							// The frame number of the context when the compressed texture was made.
+	ThreadSafeRef <AwCompressionJob> mCompressionJob;	// The compression which is in flight, if any.
+	ThreadSafeRef <AwCacheWriteJob> mCacheWriteJob;		// The bitmap cache write which was queued last, if any. It owns everything it needs, so it's never waited on.
+	ThreadSafeRef <AwCacheLoadJob> mCacheLoadJob;		// The bitmap cache load waiting in AwCacheLoader, if any.
 
 	static AwTextureTarget *sMouseInputTarget;			// The active texture target, if there is one.
 	SFXTrack *mOnGainMouseInputSound;					// The sound profile to play when gaining mouse input.
@@ -67,10 +130,24 @@ class AwTextureTarget : public SimObject
 	NamedTexTarget mTexTarget;							// Torque's named texture target.
 
 	void initContext ();
+	void updateCachePaths ();							// Works out where the bitmap cache files of this target are kept.
+	void createContext (const String &url);				// Creates the context with the target's settings and loads the URL.
+	void hibernate ();									// Saves the last texture, URL and the state posted back by the page, and destroys the context.
+	void wake ();										// Recreates the context from the saved URL and state. The last texture is shown until the page has loaded.
 	GFXTextureObject *onRender (U32 index);
-	void update (U32 fps);
+	void update (U32 fps);								// Cheap per-frame bookkeeping: pausing, framerate and resolution. Calculates the priority for the scheduler.
+	void runUpdate ();									// Uploads the frame which is ready and collects the next one. Called by the scheduler in AwManager.
+	void deferUpdate (U32 bytes);						// Called by the scheduler in AwManager when there's no budget left for this target this frame.
+	U32 getPendingUploadBytes ();						// Returns roughly how many bytes runUpdate () would upload right now.
+	void latchMetrics ();								// Takes over the metrics reported this frame.
+	F32 getDetail ();									// Returns the share (0-1) of the full framerate the target deserves, based on the load balancing mode.
+	void updateResolutionLOD ();						// Picks the resolution tier from the distance and resizes the context if it changed.
 	void onLoseMouseInput ();
 	void onGainMouseInput ();
+	bool wantsCompressedTexture ();						// Returns true if the target should currently be shown with a compressed texture.
+	void beginCompression ();							// Snapshots the context and starts compressing it on a worker thread.
+	void finishCompression (bool wait);					// Swaps in the compressed texture if the compression is done. Optionally waits for it.
+	void cancelCompression ();							// Drops the compression in flight, if any, and leaves compressed mode. The caller has to give the context its textures back.
 
 public:
 	AwTextureTarget ();
@@ -87,6 +164,10 @@ public:
 	SFXTrack *getOnGainMouseInputSound () { return mOnGainMouseInputSound; }
 	SFXTrack *getOnLoseMouseInputSound () { return mOnLoseMouseInputSound; }
 
+	U32 getDeferredBytes () const { return mDeferredBytes; } // Bytes of uploads deferred this frame because the budget was used up.
+	U32 getWorstStaleness () const { return mWorstStaleness; } // The longest a ready frame has waited for its upload, in milliseconds.
+	void resetWorstStaleness () { mWorstStaleness = 0; }
+	F32 getPriority () const { return mPriority; }		// How urgently the target wants an update this frame. 0 if it doesn't need one.
 	U32 getActualFramerate () const { return mActualFramerate; } // The actual framerate which is calculated based on how distance, mouse focus and other parameters.
 	U32 getFramerate () { return mFramerate; }			// The amount of frames per second to render. 0 means unlimited.
 	GFXTexHandle getTexture ();							// Returns the texture. The data can be from the cache or from the context.
@@ -97,11 +178,26 @@ public:
 
 	void execJavaScript (const String &script);			// Executes JavaScript for this AwTextureTarget.
 	bool isPaused ();									// Whether or not rendering of this view is paused.
-	void setDistance (F32 distance) { if (distance > mLargestDistanceThisUpdate) mLargestDistanceThisUpdate = distance; } // TODO: Move this to AwShape, as it has no business in this general purpose class.
+	bool isHibernating () { return mIsHibernating; }	// Returns true if the view has been destroyed to save memory. It's recreated when the target becomes visible.
+	void markVisible () { mLastVisibleFrame = AwManager::getFrameNumber (); } // Called when something showing this target survives culling or gets drawn.
+	bool isVisible () { return mLastVisibleFrame != 0 && mLastVisibleFrame + 1 >= AwManager::getFrameNumber (); } // Returns true if the target was visible this frame or the previous one.
+	void reportDistance (F32 distance);					// Reports the distance to a shape showing this target.
+	void reportVisibleInstance (F32 screenArea);		// Called once per frame for each shape showing this target which survived culling, with how many pixels it covers.
+	const AwTargetMetrics &getMetrics () { return mMetrics; } // Returns the metrics of all shapes showing this target, as of the last frame.
+	U32 getNumShapesBound () { return mNumShapesBound; }	// Returns how many shapes show this target.
 	void reload ();										// Reloads the view, optionally ignoring the cache.
 	U32 getRefCount () { return mRefCount; }			// How many references this AwTextureTarget has. When this reaches zero, the target is freed.
 	bool isSingleFrame () { return mIsSingleFrame; }	// Returns true if this AwTextureTarget only generates a single frame. This consumes much less resources than a regular AwTextureTarget.
-	Point2I getResolution () { return mResolution; }	// Returns the current resolution.
+	Point2I getResolution ();							// Returns the resolution the page is currently rendered at, which is lower than the full resolution when far away.
+	U32 getResolutionLOD () { return mResolutionLOD; }	// Returns the current resolution tier. 0 is full resolution, each tier halves it.
+	bool isCursorOverlay () { return mCursorOverlay; }	// Returns true if the cursor is drawn on top of the texture instead of being composited into it.
+	bool usesBitmapCache () { return mUseBitmapCache; }	// Returns true if the target shows a cached snapshot while its page loads.
+	bool hasCacheFile ();								// Returns true if a bitmap cache file exists for the target's current key.
+	AwContext *createPrerenderContext ();				// Creates a context which renders the start page at full resolution, without textures. Used to fill the cache ahead of time.
+	bool queueCacheWrite (AwContext *context);			// Copies the context's pixels and writes them to the bitmap cache on a worker.
+	bool finishCacheLoad (AwCacheLoadJob *job);			// Uploads the decoded cache file and shows it, unless the page got there first. Called by AwCacheLoader. Returns true if a texture was uploaded.
+	GFXTexHandle getCursorTexture ();					// Returns the cursor bitmap as a texture, for drawing it as an overlay.
+	F32 getDirtyAreaRatio ();							// Returns the fraction of the texture which was uploaded by the most recent copy.
 
 	static void initPersistFields ();
 };
\ No newline at end of file